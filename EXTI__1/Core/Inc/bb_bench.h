@@ -0,0 +1,34 @@
+/*
+ * Bit-band vs read-modify-write benchmark
+ *
+ * Each case runs BB_BENCH_N times, timed with the DWT cycle counter (must be
+ * enabled by the caller), loop overhead subtracted.
+ *   *_rmw : PRIMASK saved, interrupts off, |= / &= / ^=, PRIMASK restored
+ *           (what a plain RMW needs to be safe against ISRs)
+ *   *_bb  : one access of the bit-band alias, interrupts stay on
+ * Results in 'bb_bench', cycles per BB_BENCH_N operations (watch in the debugger).
+ */
+
+#ifndef INC_BB_BENCH_H_
+#define INC_BB_BENCH_H_
+
+#include "stm32f4xx.h"
+
+#define BB_BENCH_N    1000U
+
+typedef struct
+{
+	uint32_t loop;                 // Empty loop, already subtracted below
+	uint32_t gpio_toggle_rmw;      // GPIOA->ODR ^= PA5
+	uint32_t gpio_toggle_bb;
+	uint32_t exti_imr_rmw;         // EXTI->IMR set + clear of an unused line
+	uint32_t exti_imr_bb;
+	uint32_t sram_flag_rmw;        // Flag word set + clear
+	uint32_t sram_flag_bb;
+} bb_bench_t;
+
+extern volatile bb_bench_t bb_bench;
+
+void bb_bench_run(void);
+
+#endif /* INC_BB_BENCH_H_ */
@@ -0,0 +1,49 @@
+/*
+ * Cortex-M4 bit-band alias access
+ *
+ * Every bit of the first 1 MB of SRAM (0x2000 0000) and of the peripherals
+ * (0x4000 0000) has its own word in the alias regions (0x2200 0000 / 0x4200 0000):
+ *   alias = bb_base + (byte_offset * 32) + (bit * 4)
+ * Reading the alias word returns the bit (0 / 1), writing it changes that bit
+ * only, done by the bus as one locked read-modify-write: an ISR touching other
+ * bits of the same word cannot be overwritten, no need to mask interrupts.
+ *
+ *   BB_PERIPH(EXTI->IMR, 13) = 1;            (register lvalue, bit number)
+ *   BB_SRAM(flags, 3) = 0;                   (uint32_t variable in SRAM)
+ * Addresses fold to constants when register / variable and bit are constant.
+ *
+ * NOT for flag registers that clear on write (EXTI->PR, TIMx->SR, USART SR,
+ * DMA LIFCR / HIFCR): the bus read-modify-write writes back the other bits too,
+ * which clears (rc_w1) or can lose (rc_w0) flags. Use regclr.h for those.
+ */
+
+#ifndef INC_BITBAND_H_
+#define INC_BITBAND_H_
+
+#include "stm32f4xx.h"
+
+#define BB_PERIPH_ADDR(addr, bit) \
+	(PERIPH_BB_BASE + (((uint32_t)(addr) - PERIPH_BASE) * 32U) + ((uint32_t)(bit) * 4U))
+#define BB_SRAM_ADDR(addr, bit) \
+	(SRAM_BB_BASE + (((uint32_t)(addr) - SRAM_BASE) * 32U) + ((uint32_t)(bit) * 4U))
+
+#define BB_PERIPH(reg, bit)   (*(volatile uint32_t *)BB_PERIPH_ADDR(&(reg), (bit)))
+#define BB_SRAM(var, bit)     (*(volatile uint32_t *)BB_SRAM_ADDR(&(var), (bit)))
+
+// SRAM flag words shared between ISRs and the main loop
+static inline void bb_flag_set(volatile uint32_t *word, uint32_t bit)
+{
+	*(volatile uint32_t *)BB_SRAM_ADDR(word, bit) = 1U;
+}
+
+static inline void bb_flag_clear(volatile uint32_t *word, uint32_t bit)
+{
+	*(volatile uint32_t *)BB_SRAM_ADDR(word, bit) = 0U;
+}
+
+static inline uint32_t bb_flag_get(volatile uint32_t *word, uint32_t bit)
+{
+	return *(volatile uint32_t *)BB_SRAM_ADDR(word, bit);
+}
+
+#endif /* INC_BITBAND_H_ */
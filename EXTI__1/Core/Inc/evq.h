@@ -0,0 +1,72 @@
+/*
+ * Lock-free event queues from ISRs to the main loop
+ *
+ * evq_t    single producer / single consumer (one ISR -> main loop)
+ *          head written only by the producer, tail only by the consumer,
+ *          a DMB orders the entry against the index that publishes it
+ * evq_mp_t multi producer / single consumer (several ISRs, any priorities -> main loop)
+ *          producers reserve a slot with LDREX/STREX on head, every slot has a
+ *          sequence number that says when its entry is complete (bounded MPMC
+ *          ring scheme, consumer side reduced to one reader)
+ *
+ * Neither queue disables interrupts. A full queue rejects the event and counts it.
+ * Sizes are powers of two, buffers are supplied by the caller.
+ */
+
+#ifndef INC_EVQ_H_
+#define INC_EVQ_H_
+
+#include "stm32f4xx.h"
+
+typedef struct
+{
+	uint8_t  type;                 // Application defined
+	uint8_t  src;                  // e.g. EXTI line, peripheral number
+	uint16_t arg;
+	uint32_t data;
+	uint32_t ts;                   // Timestamp, unit chosen by the producer
+} evq_event_t;
+
+typedef void (*evq_fn_t)(const evq_event_t *ev);
+
+/*==========================================================*/
+
+typedef struct
+{
+	evq_event_t *buf;
+	uint32_t mask;                 // size - 1
+	volatile uint32_t head;        // Next write, producer only
+	volatile uint32_t tail;        // Next read, consumer only
+	volatile uint32_t drops;       // Producer only
+} evq_t;
+
+void evq_init(evq_t *q, evq_event_t *buf, uint32_t size);
+int evq_put(evq_t *q, const evq_event_t *ev);            // 0, or -1 if full
+uint8_t evq_get(evq_t *q, evq_event_t *ev);              // 1 = event returned
+uint32_t evq_drain(evq_t *q, evq_fn_t fn, uint32_t max); // Up to max events, tail published once
+uint8_t evq_empty(const evq_t *q);
+
+/*==========================================================*/
+
+typedef struct
+{
+	volatile uint32_t seq;
+	evq_event_t ev;
+} evq_slot_t;
+
+typedef struct
+{
+	evq_slot_t *buf;
+	uint32_t mask;
+	volatile uint32_t head;        // Reserved by producers (LDREX/STREX)
+	volatile uint32_t tail;        // Consumer only
+	volatile uint32_t drops;       // LDREX/STREX, several writers
+} evq_mp_t;
+
+void evq_mp_init(evq_mp_t *q, evq_slot_t *buf, uint32_t size);
+int evq_mp_put(evq_mp_t *q, const evq_event_t *ev);
+uint8_t evq_mp_get(evq_mp_t *q, evq_event_t *ev);
+uint32_t evq_mp_drain(evq_mp_t *q, evq_fn_t fn, uint32_t max);
+uint8_t evq_mp_empty(const evq_mp_t *q);                 // Also 1 while the next entry is still being written
+
+#endif /* INC_EVQ_H_ */
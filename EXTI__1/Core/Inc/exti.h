@@ -0,0 +1,39 @@
+/*
+ * EXTI driver: registration + dispatch for all 16 GPIO lines
+ *
+ * - exti_register() sets SYSCFG->EXTICR (port), RTSR / FTSR (edges),
+ *   IMR and the NVIC vector of the line in one call
+ * - EXTI0 .. EXTI4 have their own vector, lines 5..9 share EXTI9_5 and
+ *   10..15 share EXTI15_10: the shared handlers look only at PR & IMR of
+ *   their own lines and walk the set bits with CLZ, unused lines cost nothing
+ * - Callbacks run in the EXTI interrupt, the pending bit is already cleared
+ *   (a new edge during the callback is kept and runs the callback again)
+ */
+
+#ifndef INC_EXTI_H_
+#define INC_EXTI_H_
+
+#include "stm32f4xx.h"
+
+#define EXTI_LINES     16U
+
+typedef enum
+{
+	EXTI_SOFT    = 0,              // No pin edge, only software triggers (EXTI->SWIER)
+	EXTI_RISING  = 1,
+	EXTI_FALLING = 2,
+	EXTI_BOTH    = 3
+} exti_edge_t;
+
+typedef void (*exti_cb_t)(uint32_t line, void *arg);
+
+// Line = pin number of 'port'. Shared vectors keep the priority of the last registration.
+// Returns 0, or -1 for a bad line / missing callback
+int exti_register(uint32_t line, GPIO_TypeDef *port, exti_edge_t edge,
+                  exti_cb_t cb, void *arg, uint32_t prio);
+void exti_unregister(uint32_t line);
+
+// DWT->CYCCNT at EXTI15_10_IRQHandler entry, only written in LATENCY_TEST builds (latency.h)
+extern volatile uint32_t exti_entry_cyc;
+
+#endif /* INC_EXTI_H_ */
@@ -0,0 +1,41 @@
+/*
+ * EXTI stress test: several lines on different vectors fire at a high rate
+ *
+ * - TIM6 interrupt (priority 0, above the EXTI vectors) triggers the test
+ *   lines through EXTI->SWIER at STRESS_HZ, so new lines become pending while
+ *   other EXTI handlers are running
+ * - A line is triggered again only once its previous event was seen, so every
+ *   event must arrive: issued == seen + lost, and 'lost' must stay 0
+ * - An event seen after it was counted lost moves from 'lost' to 'late'
+ * - Build with EXTI_STRESS_RMW to put the old "EXTI->PR |= bit" back in the
+ *   dispatcher: 'lost' then counts up quickly
+ *
+ * Lines 0, 1, 5, 6, 10, 11 in software trigger mode (no pin used).
+ * Results in 'exti_stress' (watch them in the debugger).
+ */
+
+#ifndef INC_EXTI_STRESS_H_
+#define INC_EXTI_STRESS_H_
+
+#include "stm32f4xx.h"
+#include "exti.h"
+
+#define STRESS_HZ       20000U
+#define STRESS_LINES    6U
+
+typedef struct
+{
+	uint32_t line[STRESS_LINES];
+	volatile uint32_t issued[STRESS_LINES];
+	volatile uint32_t seen[STRESS_LINES];      // Counted by the EXTI callbacks
+	volatile uint32_t lost[STRESS_LINES];
+	volatile uint32_t late[STRESS_LINES];      // Seen after the 2 tick limit, also in 'seen'
+	volatile uint32_t ticks;
+} exti_stress_t;
+
+extern exti_stress_t exti_stress;
+
+void exti_stress_start(void);
+void exti_stress_stop(void);
+
+#endif /* INC_EXTI_STRESS_H_ */
@@ -0,0 +1,65 @@
+/*
+ * Interrupt latency / jitter harness (build with LATENCY_TEST)
+ *
+ * Wiring: PA0 (TIM2_CH1 output) -> PB12 (EXTI line 12, EXTI15_10 vector)
+ *
+ * - TIM2 runs free, every round CCR1 is set LAT_GAP ticks ahead; on the match
+ *   the channel toggles PA0 and sets CC1IF at a time known in DWT cycles
+ * - TIM rounds: CC1 interrupt on, EXTI line 12 masked -> TIM2_IRQHandler
+ *   EXTI rounds: CC1 interrupt off, line 12 unmasked -> EXTI15_10_IRQHandler
+ *   (one source at a time, they never tail-chain into each other)
+ * - Both handlers read DWT->CYCCNT first thing; latency = entry - match
+ *   (includes the GPIO input synchroniser for EXTI and the few cycles of
+ *   the APB read that maps TIM2->CNT to CYCCNT, same for every round)
+ * - Every source is measured under every background load the main loop can
+ *   generate while it waits: spin, WFI, flash reads, SRAM copies, DMA2 traffic
+ * - Per case: histogram (1 cycle per bin), min / mean / max / jitter, printed
+ *   on USART2 (ST-LINK VCP); a case over LAT_LIMIT_* cycles is a FAIL
+ */
+
+#ifndef INC_LATENCY_H_
+#define INC_LATENCY_H_
+
+#include "stm32f4xx.h"
+
+#define LAT_ROUNDS          1000U
+#define LAT_GAP             2000U      // TIM2 ticks from arming to the match
+#define LAT_BINS            64U        // Last bin counts everything above
+#define LAT_LIMIT_TIM       40U        // Max accepted entry latency, cycles
+#define LAT_LIMIT_EXTI      48U
+#define LAT_EXTI_LINE       12U
+
+typedef enum
+{
+	LAT_SRC_TIM = 0,
+	LAT_SRC_EXTI,
+	LAT_SRC_COUNT
+} lat_src_t;
+
+typedef enum
+{
+	LAT_LOAD_SPIN = 0,                 // Main loop busy, no bus traffic of its own
+	LAT_LOAD_SLEEP,                    // WFI, wake-up on the interrupt
+	LAT_LOAD_FLASH,                    // Flash reads past the ART cache
+	LAT_LOAD_SRAM,                     // memcpy (LDM / STM) SRAM -> SRAM
+	LAT_LOAD_DMA,                      // DMA2 memory-to-memory on the bus matrix
+	LAT_LOAD_COUNT
+} lat_load_t;
+
+typedef struct
+{
+	uint32_t hist[LAT_BINS];
+	uint32_t n;
+	uint32_t missed;                   // No interrupt within the timeout
+	uint32_t min;
+	uint32_t max;
+	uint32_t sum;
+	uint32_t dispatch_max;             // EXTI: entry -> callback (exti.c dispatcher)
+} lat_result_t;
+
+extern lat_result_t lat_results[LAT_SRC_COUNT][LAT_LOAD_COUNT];
+
+// Runs every case, prints the report. Returns the number of failed cases.
+uint32_t lat_run(void);
+
+#endif /* INC_LATENCY_H_ */
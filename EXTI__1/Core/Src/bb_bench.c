@@ -0,0 +1,103 @@
+/*
+ * Bit-band vs read-modify-write benchmark (see bb_bench.h)
+ */
+
+#include "bb_bench.h"
+#include "bitband.h"
+
+#define BENCH_LINE    2U                   // EXTI line not used by the application
+
+volatile bb_bench_t bb_bench;
+
+static volatile uint32_t flags;
+
+/*==========================================================*/
+
+static uint32_t masked_begin(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	return primask;
+}
+
+static void masked_end(uint32_t primask)
+{
+	__set_PRIMASK(primask);
+}
+
+static uint32_t elapsed(uint32_t start)
+{
+	uint32_t c = DWT->CYCCNT - start;
+
+	return (c > bb_bench.loop) ? (c - bb_bench.loop) : 0U;
+}
+
+/*==========================================================*/
+
+void bb_bench_run(void)
+{
+	uint32_t t, primask;
+
+	bb_bench.loop = 0;
+	t = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BB_BENCH_N; i++)
+	{
+		__NOP();
+	}
+	bb_bench.loop = DWT->CYCCNT - t;
+
+	// GPIO output toggle
+	t = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BB_BENCH_N; i++)
+	{
+		primask = masked_begin();
+		GPIOA->ODR ^= (1U << 5);
+		masked_end(primask);
+	}
+	bb_bench.gpio_toggle_rmw = elapsed(t);
+
+	t = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BB_BENCH_N; i++)
+	{
+		BB_PERIPH(GPIOA->ODR, 5) ^= 1U;
+	}
+	bb_bench.gpio_toggle_bb = elapsed(t);
+
+	// EXTI mask bit
+	t = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BB_BENCH_N; i++)
+	{
+		primask = masked_begin();
+		EXTI->IMR |= (1U << BENCH_LINE);
+		EXTI->IMR &= ~(1U << BENCH_LINE);
+		masked_end(primask);
+	}
+	bb_bench.exti_imr_rmw = elapsed(t);
+
+	t = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BB_BENCH_N; i++)
+	{
+		BB_PERIPH(EXTI->IMR, BENCH_LINE) = 1;
+		BB_PERIPH(EXTI->IMR, BENCH_LINE) = 0;
+	}
+	bb_bench.exti_imr_bb = elapsed(t);
+
+	// SRAM flag word
+	t = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BB_BENCH_N; i++)
+	{
+		primask = masked_begin();
+		flags |= (1U << 7);
+		flags &= ~(1U << 7);
+		masked_end(primask);
+	}
+	bb_bench.sram_flag_rmw = elapsed(t);
+
+	t = DWT->CYCCNT;
+	for (uint32_t i = 0; i < BB_BENCH_N; i++)
+	{
+		bb_flag_set(&flags, 7);
+		bb_flag_clear(&flags, 7);
+	}
+	bb_bench.sram_flag_bb = elapsed(t);
+}
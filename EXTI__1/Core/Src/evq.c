@@ -0,0 +1,183 @@
+/*
+ * Lock-free event queues (see evq.h)
+ */
+
+#include "evq.h"
+
+/*==========================================================*/
+/*
+ * SPSC
+ * Indices run freely, head - tail = entries in use (unsigned wrap is fine).
+ */
+
+void evq_init(evq_t *q, evq_event_t *buf, uint32_t size)
+{
+	q->buf = buf;
+	q->mask = size - 1U;
+	q->head = 0;
+	q->tail = 0;
+	q->drops = 0;
+}
+
+int evq_put(evq_t *q, const evq_event_t *ev)
+{
+	uint32_t head = q->head;
+
+	if ((head - q->tail) > q->mask)
+	{
+		q->drops++;
+		return -1;
+	}
+
+	q->buf[head & q->mask] = *ev;
+	__DMB();                                   // Entry written before it is published
+	q->head = head + 1U;
+	return 0;
+}
+
+uint8_t evq_get(evq_t *q, evq_event_t *ev)
+{
+	uint32_t tail = q->tail;
+
+	if (tail == q->head)
+	{
+		return 0;
+	}
+	__DMB();                                   // Index read before the entry
+	*ev = q->buf[tail & q->mask];
+	__DMB();                                   // Entry copied before the slot is handed back
+	q->tail = tail + 1U;
+	return 1;
+}
+
+uint32_t evq_drain(evq_t *q, evq_fn_t fn, uint32_t max)
+{
+	uint32_t tail = q->tail;
+	uint32_t avail = q->head - tail;
+	uint32_t n = (avail < max) ? avail : max;
+
+	__DMB();
+	for (uint32_t i = 0; i < n; i++)
+	{
+		fn(&q->buf[(tail + i) & q->mask]);
+	}
+	__DMB();
+	q->tail = tail + n;                        // All n slots freed with one store
+	return n;
+}
+
+uint8_t evq_empty(const evq_t *q)
+{
+	return (q->head == q->tail) ? 1U : 0U;
+}
+
+/*==========================================================*/
+/*
+ * MPSC
+ * Slot i starts with seq = i.
+ *   seq == pos       free for the producer that reserves position pos
+ *   seq == pos + 1   written, readable by the consumer at position pos
+ *   consumer frees it with seq = pos + size (free for the next lap)
+ * A producer preempted between reserve and publish only delays the consumer
+ * at that slot, later slots stay queued behind it, nothing is lost.
+ */
+
+void evq_mp_init(evq_mp_t *q, evq_slot_t *buf, uint32_t size)
+{
+	q->buf = buf;
+	q->mask = size - 1U;
+	for (uint32_t i = 0; i < size; i++)
+	{
+		buf[i].seq = i;
+	}
+	q->head = 0;
+	q->tail = 0;
+	q->drops = 0;
+}
+
+static void mp_count_drop(evq_mp_t *q)
+{
+	uint32_t d;
+
+	do
+	{
+		d = __LDREXW(&q->drops);
+	} while (__STREXW(d + 1U, &q->drops) != 0U);
+}
+
+int evq_mp_put(evq_mp_t *q, const evq_event_t *ev)
+{
+	uint32_t pos;
+	evq_slot_t *s;
+
+	// Reserve: head -> head + 1, retried if another producer got in between
+	while (1)
+	{
+		pos = __LDREXW(&q->head);
+		s = &q->buf[pos & q->mask];
+
+		if ((int32_t)(s->seq - pos) < 0)
+		{
+			__CLREX();
+			mp_count_drop(q);                  // Slot of the previous lap not read yet: full
+			return -1;
+		}
+		if (__STREXW(pos + 1U, &q->head) == 0U)
+		{
+			break;
+		}
+	}
+
+	s->ev = *ev;
+	__DMB();                                   // Entry written before seq publishes it
+	s->seq = pos + 1U;
+	return 0;
+}
+
+uint8_t evq_mp_get(evq_mp_t *q, evq_event_t *ev)
+{
+	uint32_t pos = q->tail;
+	evq_slot_t *s = &q->buf[pos & q->mask];
+
+	if (s->seq != (pos + 1U))
+	{
+		return 0;                              // Empty, or the next entry is not complete yet
+	}
+	__DMB();
+	*ev = s->ev;
+	__DMB();
+	s->seq = pos + q->mask + 1U;               // Free for the next lap
+	q->tail = pos + 1U;
+	return 1;
+}
+
+uint32_t evq_mp_drain(evq_mp_t *q, evq_fn_t fn, uint32_t max)
+{
+	uint32_t pos = q->tail;
+	uint32_t n = 0;
+
+	while (n < max)
+	{
+		evq_slot_t *s = &q->buf[pos & q->mask];
+
+		if (s->seq != (pos + 1U))
+		{
+			break;
+		}
+		__DMB();
+		fn(&s->ev);
+		__DMB();
+		s->seq = pos + q->mask + 1U;
+		pos++;
+		n++;
+	}
+	q->tail = pos;
+	return n;
+}
+
+uint8_t evq_mp_empty(const evq_mp_t *q)
+{
+	uint32_t pos = q->tail;
+
+	return (q->buf[pos & q->mask].seq != (pos + 1U)) ? 1U : 0U;
+}
@@ -0,0 +1,154 @@
+/*
+ * EXTI driver (see exti.h)
+ */
+
+#include "exti.h"
+#include "regclr.h"
+#include "bitband.h"
+
+#define EXTI_9_5_MASK     0x03E0U          // Lines 5..9
+#define EXTI_15_10_MASK   0xFC00U          // Lines 10..15
+
+typedef struct
+{
+	exti_cb_t cb;
+	void *arg;
+} exti_slot_t;
+
+static exti_slot_t slots[EXTI_LINES];
+
+volatile uint32_t exti_entry_cyc;
+
+/*==========================================================*/
+
+static IRQn_Type line_irq(uint32_t line)
+{
+	if (line <= 4U)
+	{
+		return (IRQn_Type)(EXTI0_IRQn + (int32_t)line);     // EXTI0..4 are consecutive
+	}
+	return (line <= 9U) ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+int exti_register(uint32_t line, GPIO_TypeDef *port, exti_edge_t edge,
+                  exti_cb_t cb, void *arg, uint32_t prio)
+{
+	if ((line >= EXTI_LINES) || (cb == 0))
+	{
+		return -1;
+	}
+
+	uint32_t bit = 1U << line;
+	uint32_t port_idx = ((uint32_t)port - GPIOA_BASE) / 0x400U;    // A = 0, B = 1, ...
+
+	BB_PERIPH(RCC->APB2ENR, RCC_APB2ENR_SYSCFGEN_Pos) = 1;
+	(void)RCC->APB2ENR;
+
+	// Line masked while it is changed
+	// IMR / RTSR / FTSR bits through bit-band: other lines can be (un)registered
+	// from an ISR without a lost update and without masking interrupts.
+	// EXTICR is a 4-bit field shared by 4 lines, so it needs a short PRIMASK section.
+	BB_PERIPH(EXTI->IMR, line) = 0;
+
+	slots[line].cb = cb;
+	slots[line].arg = arg;
+
+	// 4 bits per line, 4 lines per EXTICR register: one read / modify / store
+	uint32_t shift = (line & 3U) * 4U;
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	SYSCFG->EXTICR[line >> 2] = (SYSCFG->EXTICR[line >> 2] & ~(0xFU << shift)) | (port_idx << shift);
+	__set_PRIMASK(primask);
+
+	BB_PERIPH(EXTI->RTSR, line) = (edge & EXTI_RISING) ? 1U : 0U;
+	BB_PERIPH(EXTI->FTSR, line) = (edge & EXTI_FALLING) ? 1U : 0U;
+
+	exti_pr_clear(bit);                        // rc_w1: drop a stale edge of this line only
+	BB_PERIPH(EXTI->IMR, line) = 1;
+
+	NVIC_SetPriority(line_irq(line), prio);
+	NVIC_EnableIRQ(line_irq(line));
+
+	return 0;
+}
+
+void exti_unregister(uint32_t line)
+{
+	if (line >= EXTI_LINES)
+	{
+		return;
+	}
+
+	BB_PERIPH(EXTI->IMR, line) = 0;
+	BB_PERIPH(EXTI->RTSR, line) = 0;
+	BB_PERIPH(EXTI->FTSR, line) = 0;
+	exti_pr_clear(1U << line);
+	slots[line].cb = 0;
+}
+
+/*==========================================================*/
+/*
+ * Dispatch of one vector
+ * - Only enabled lines of this vector: PR & IMR & group
+ * - Their pending bits are cleared with one write (rc_w1, other lines untouched)
+ *   BEFORE the callbacks, so an edge during a callback is not lost
+ * - Highest line first, one CLZ per pending line
+ */
+
+static void exti_dispatch(uint32_t group)
+{
+	uint32_t pending = EXTI->PR & EXTI->IMR & group;
+
+#ifdef EXTI_STRESS_RMW
+	EXTI->PR |= pending;                       // Old read-modify-write, only to show the loss (exti_stress.h)
+#else
+	exti_pr_clear(pending);
+#endif
+
+	while (pending != 0U)
+	{
+		uint32_t line = 31U - __CLZ(pending);
+
+		pending &= ~(1U << line);
+		slots[line].cb(line, slots[line].arg);
+	}
+}
+
+void EXTI0_IRQHandler(void)
+{
+	exti_dispatch(1U << 0);
+}
+
+void EXTI1_IRQHandler(void)
+{
+	exti_dispatch(1U << 1);
+}
+
+void EXTI2_IRQHandler(void)
+{
+	exti_dispatch(1U << 2);
+}
+
+void EXTI3_IRQHandler(void)
+{
+	exti_dispatch(1U << 3);
+}
+
+void EXTI4_IRQHandler(void)
+{
+	exti_dispatch(1U << 4);
+}
+
+void EXTI9_5_IRQHandler(void)
+{
+	exti_dispatch(EXTI_9_5_MASK);
+}
+
+void EXTI15_10_IRQHandler(void)
+{
+#ifdef LATENCY_TEST
+	exti_entry_cyc = DWT->CYCCNT;
+#endif
+	exti_dispatch(EXTI_15_10_MASK);
+}
@@ -0,0 +1,112 @@
+/*
+ * EXTI stress test (see exti_stress.h)
+ */
+
+#include "exti_stress.h"
+#include "regclr.h"
+
+exti_stress_t exti_stress;
+
+static const uint8_t test_lines[STRESS_LINES] = { 0, 1, 5, 6, 10, 11 };
+static uint8_t waiting[STRESS_LINES];          // Ticks since the last trigger was not seen
+
+/*==========================================================*/
+
+static void stress_cb(uint32_t line, void *arg)
+{
+	uint32_t i = (uint32_t)arg;
+
+	(void)line;
+	exti_stress.seen[i]++;
+}
+
+void exti_stress_start(void)
+{
+	uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+	uint32_t timclk;
+
+	for (uint32_t i = 0; i < STRESS_LINES; i++)
+	{
+		exti_stress.line[i] = test_lines[i];
+		exti_stress.issued[i] = 0;
+		exti_stress.seen[i] = 0;
+		exti_stress.lost[i] = 0;
+		exti_stress.late[i] = 0;
+		waiting[i] = 0;
+		exti_register(test_lines[i], GPIOA, EXTI_SOFT, stress_cb, (void *)i, 1);
+	}
+	exti_stress.ticks = 0;
+
+	SystemCoreClockUpdate();
+	timclk = SystemCoreClock >> APBPrescTable[ppre1];
+	if (APBPrescTable[ppre1] != 0U)
+	{
+		timclk *= 2U;                              // APB1 timers run at 2 x PCLK1
+	}
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM6EN;
+	(void)RCC->APB1ENR;
+
+	TIM6->CR1 = 0;
+	TIM6->PSC = 0;
+	TIM6->ARR = (timclk / STRESS_HZ) - 1U;
+	TIM6->EGR = TIM_EGR_UG;
+	TIM6->SR = 0;
+	TIM6->DIER = TIM_DIER_UIE;
+
+	NVIC_SetPriority(TIM6_DAC_IRQn, 0);            // Preempts the EXTI handlers
+	NVIC_EnableIRQ(TIM6_DAC_IRQn);
+
+	TIM6->CR1 = TIM_CR1_CEN;
+}
+
+void exti_stress_stop(void)
+{
+	TIM6->CR1 = 0;
+	NVIC_DisableIRQ(TIM6_DAC_IRQn);
+
+	for (uint32_t i = 0; i < STRESS_LINES; i++)
+	{
+		exti_unregister(test_lines[i]);
+	}
+}
+
+/*==========================================================*/
+/*
+ * Every tick: all lines whose last event has arrived are triggered together
+ * with one SWIER write. A line still waiting after 2 ticks (100 us at 20 kHz,
+ * far above the EXTI latency) has lost its event. If it still arrives later,
+ * seen + lost runs one past issued: the loss is taken back and counted late,
+ * otherwise the line would never be triggered again.
+ * seen cannot change in here, the EXTI callbacks run at a lower priority.
+ */
+
+void TIM6_DAC_IRQHandler(void)
+{
+	uint32_t fire = 0;
+
+	tim_sr_clear(TIM6, TIM_SR_UIF);
+	exti_stress.ticks++;
+
+	for (uint32_t i = 0; i < STRESS_LINES; i++)
+	{
+		if ((exti_stress.seen[i] + exti_stress.lost[i]) > exti_stress.issued[i])
+		{
+			exti_stress.lost[i]--;
+			exti_stress.late[i]++;
+		}
+
+		if (exti_stress.issued[i] == (exti_stress.seen[i] + exti_stress.lost[i]))
+		{
+			fire |= (1U << test_lines[i]);
+			exti_stress.issued[i]++;
+			waiting[i] = 0;
+		}
+		else if (++waiting[i] >= 2U)
+		{
+			exti_stress.lost[i]++;                 // Next tick triggers it again
+		}
+	}
+
+	EXTI->SWIER = fire;                            // 1 sets the pending bit, 0 has no effect
+}
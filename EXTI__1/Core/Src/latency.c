@@ -0,0 +1,260 @@
+/*
+ * Interrupt latency / jitter harness (see latency.h)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "latency.h"
+#include "exti.h"
+#include "uart.h"
+#include "regclr.h"
+#include "bitband.h"
+
+#define DMA_WORDS    256U
+
+lat_result_t lat_results[LAT_SRC_COUNT][LAT_LOAD_COUNT];
+
+static volatile uint32_t hit_cyc;              // CYCCNT at handler entry
+static volatile uint32_t cb_cyc;               // CYCCNT in the EXTI callback
+static volatile uint8_t hit;
+
+static uint32_t ratio;                         // Core clocks per TIM2 tick
+static uint32_t sram_a[DMA_WORDS], sram_b[DMA_WORDS];
+static volatile uint32_t sink;
+
+static const char *const src_name[LAT_SRC_COUNT] = { "TIM2", "EXTI" };
+static const char *const load_name[LAT_LOAD_COUNT] = { "spin", "sleep", "flash", "sram", "dma" };
+static const uint32_t limit[LAT_SRC_COUNT] = { LAT_LIMIT_TIM, LAT_LIMIT_EXTI };
+
+/*==========================================================*/
+/*
+ * PA0: TIM2_CH1 (AF1), PB12: input, EXTI line 12 both edges
+ * TIM2: free running 32-bit, no prescaler, CH1 toggle on match
+ */
+
+static void lat_hw_init(void)
+{
+	uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+
+	SystemCoreClockUpdate();
+	ratio = (APBPrescTable[ppre1] <= 1U) ? 1U : (1U << (APBPrescTable[ppre1] - 1U));   // HCLK / TIM2 clock
+
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_DMA2EN;
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+	(void)RCC->APB1ENR;
+
+	GPIOA->AFR[0] = (GPIOA->AFR[0] & ~(0xFU << 0)) | (1U << 0);
+	GPIOA->OSPEEDR |= (3U << 0);
+	GPIOA->MODER = (GPIOA->MODER & ~(3U << 0)) | (2U << 0);
+
+	GPIOB->MODER &= ~(3U << (LAT_EXTI_LINE * 2U));
+	GPIOB->PUPDR &= ~(3U << (LAT_EXTI_LINE * 2U));
+
+	TIM2->CR1 = 0;
+	TIM2->PSC = 0;
+	TIM2->ARR = 0xFFFFFFFFU;
+	TIM2->CCMR1 = (3U << TIM_CCMR1_OC1M_Pos);                  // Toggle on match, no preload
+	TIM2->CCER = TIM_CCER_CC1E;
+	TIM2->DIER = 0;
+	TIM2->EGR = TIM_EGR_UG;
+	tim_sr_clear(TIM2, TIM_SR_CC1IF);
+
+	NVIC_SetPriority(TIM2_IRQn, 1);
+	NVIC_EnableIRQ(TIM2_IRQn);
+
+	TIM2->CR1 = TIM_CR1_CEN;
+}
+
+static void lat_exti_cb(uint32_t line, void *arg)
+{
+	cb_cyc = DWT->CYCCNT;
+	hit_cyc = exti_entry_cyc;
+	hit = 1;
+}
+
+/*==========================================================*/
+/*
+ * Background loads, one short step per call so the wait loop sees 'hit' soon
+ */
+
+static void dma_load_start(void)
+{
+	DMA2_Stream0->CR &= ~DMA_SxCR_EN;
+	while (DMA2_Stream0->CR & DMA_SxCR_EN){}
+	dma_stream_clear(DMA2, 0);
+
+	// Channel0, memory -> memory, 32-bit, both increment, very high priority
+	DMA2_Stream0->PAR = (uint32_t)sram_a;
+	DMA2_Stream0->M0AR = (uint32_t)sram_b;
+	DMA2_Stream0->NDTR = DMA_WORDS;
+	DMA2_Stream0->CR = DMA_SxCR_PL | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 |
+	                   DMA_SxCR_MINC | DMA_SxCR_PINC | DMA_SxCR_DIR_1;
+	DMA2_Stream0->CR |= DMA_SxCR_EN;
+}
+
+static void load_step(lat_load_t load, uint32_t *pos)
+{
+	switch (load)
+	{
+	case LAT_LOAD_SLEEP:
+		__WFI();
+		break;
+	case LAT_LOAD_FLASH:
+	{
+		// 64 KB of the image, one word per 32 bytes: every read misses the ART lines
+		const volatile uint32_t *f = (const volatile uint32_t *)FLASH_BASE;
+
+		sink += f[(*pos & 0x7FFU) * 8U];
+		(*pos)++;
+		break;
+	}
+	case LAT_LOAD_SRAM:
+		memcpy(sram_b, sram_a, 64U * sizeof(uint32_t));
+		break;
+	case LAT_LOAD_DMA:
+		if (!(DMA2_Stream0->CR & DMA_SxCR_EN))
+		{
+			dma_load_start();                              // Keep the bus matrix busy
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/*==========================================================*/
+
+static void lat_case(lat_src_t src, lat_load_t load, lat_result_t *r)
+{
+	uint32_t pos = 0;
+
+	memset(r, 0, sizeof(*r));
+	r->min = 0xFFFFFFFFU;
+
+	// One source at a time
+	if (src == LAT_SRC_TIM)
+	{
+		BB_PERIPH(EXTI->IMR, LAT_EXTI_LINE) = 0;
+		TIM2->DIER = TIM_DIER_CC1IE;
+	}
+	else
+	{
+		TIM2->DIER = 0;
+		exti_pr_clear(1U << LAT_EXTI_LINE);
+		BB_PERIPH(EXTI->IMR, LAT_EXTI_LINE) = 1;
+	}
+
+	for (uint32_t i = 0; i < LAT_ROUNDS; i++)
+	{
+		uint32_t c0, n0, match, t0;
+
+		hit = 0;
+
+		// CNT <-> CYCCNT at the same moment, the match follows LAT_GAP ticks later
+		__disable_irq();
+		c0 = DWT->CYCCNT;
+		n0 = TIM2->CNT;
+		TIM2->CCR1 = n0 + LAT_GAP;
+		__enable_irq();
+		match = c0 + (LAT_GAP * ratio);
+
+		t0 = DWT->CYCCNT;
+		while (!hit && ((DWT->CYCCNT - t0) < (4U * LAT_GAP * ratio)))
+		{
+			load_step(load, &pos);
+		}
+
+		if (!hit)
+		{
+			r->missed++;
+			continue;
+		}
+
+		uint32_t lat = hit_cyc - match;
+
+		r->hist[(lat < LAT_BINS) ? lat : (LAT_BINS - 1U)]++;
+		r->n++;
+		r->sum += lat;
+		if (lat < r->min) r->min = lat;
+		if (lat > r->max) r->max = lat;
+		if ((src == LAT_SRC_EXTI) && ((cb_cyc - hit_cyc) > r->dispatch_max))
+		{
+			r->dispatch_max = cb_cyc - hit_cyc;
+		}
+	}
+
+	TIM2->DIER = 0;
+	BB_PERIPH(EXTI->IMR, LAT_EXTI_LINE) = 0;
+	DMA2_Stream0->CR &= ~DMA_SxCR_EN;
+}
+
+static uint8_t lat_print(lat_src_t src, lat_load_t load, const lat_result_t *r)
+{
+	uint8_t fail = (r->n == 0U) || (r->missed != 0U) || (r->max > limit[src]);
+	uint32_t mean100 = (r->n != 0U) ? ((r->sum * 100U) / r->n) : 0U;
+
+	printf("%-4s %-5s %5lu %6lu %4lu %4lu.%02lu %4lu %6lu %8lu  %s\n",
+	       src_name[src], load_name[load], r->n, r->missed,
+	       (r->n != 0U) ? r->min : 0U, mean100 / 100U, mean100 % 100U, r->max,
+	       (r->n != 0U) ? (r->max - r->min) : 0U, r->dispatch_max,
+	       fail ? "FAIL" : "ok");
+
+	// Histogram, non-empty bins only
+	printf("    ");
+	for (uint32_t b = 0; b < LAT_BINS; b++)
+	{
+		if (r->hist[b] != 0U)
+		{
+			printf(" %lu%s:%lu", b, (b == (LAT_BINS - 1U)) ? "+" : "", r->hist[b]);
+		}
+	}
+	printf("\n");
+
+	return fail;
+}
+
+uint32_t lat_run(void)
+{
+	uint32_t fails = 0;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	uart2_config();
+	lat_hw_init();
+
+	for (uint32_t i = 0; i < DMA_WORDS; i++)
+	{
+		sram_a[i] = i * 0x01010101U;
+	}
+
+	// Both edges: every match toggles PA0, line masked until an EXTI case
+	exti_register(LAT_EXTI_LINE, GPIOB, EXTI_BOTH, lat_exti_cb, 0, 1);
+	BB_PERIPH(EXTI->IMR, LAT_EXTI_LINE) = 0;
+
+	printf("\nIRQ latency, HCLK %lu Hz, %u rounds, PA0 -> PB12\n", SystemCoreClock, LAT_ROUNDS);
+	printf("SRC  LOAD      n missed  min   mean  max jitter dispatch\n");
+
+	for (uint32_t s = 0; s < LAT_SRC_COUNT; s++)
+	{
+		for (uint32_t l = 0; l < LAT_LOAD_COUNT; l++)
+		{
+			lat_case((lat_src_t)s, (lat_load_t)l, &lat_results[s][l]);
+			fails += lat_print((lat_src_t)s, (lat_load_t)l, &lat_results[s][l]);
+		}
+	}
+
+	exti_unregister(LAT_EXTI_LINE);
+	printf("latency: %s (%lu failed)\n", (fails == 0U) ? "PASS" : "FAIL", fails);
+
+	return fails;
+}
+
+/*==========================================================*/
+
+void TIM2_IRQHandler(void)
+{
+	hit_cyc = DWT->CYCCNT;                     // First, before anything else
+	tim_sr_clear(TIM2, TIM_SR_CC1IF);
+	hit = 1;
+}
@@ -1,18 +1,85 @@
 /*
  * Button interrupt (EXTI) to toggle LED
+ * The EXTI callback only queues an event, the LED is handled in the main loop,
+ * which sleeps (power.h) while the queue is empty; sleep time in pwr_stats.
+ * EXTI_SLEEP_ON_EXIT: LED toggled in the interrupt, no main loop at all.
+ * EXTI_USE_STOP: STOP mode instead of Sleep (not with EXTI_STRESS / LATENCY_TEST,
+ * their timers stop too).
  */
 
 #include "stm32f4xx.h"
+#include "exti.h"
+#include "evq.h"
+#include "bitband.h"
+#include "power.h"
+#ifdef EXTI_STRESS
+#include "exti_stress.h"
+#endif
+#ifdef BITBAND_BENCH
+#include "bb_bench.h"
+#endif
+#ifdef LATENCY_TEST
+#include "latency.h"
+#endif
+
+#define EV_BUTTON   1U
+
+#ifdef EXTI_USE_STOP
+#define IDLE_MODE   PWR_STOP
+#else
+#define IDLE_MODE   PWR_SLEEP
+#endif
 
 static void gpio_config(void);
-static void EXTI_config(void);
-static void NVIC_config(void);
+static void button_event(uint32_t line, void *arg);
+static void handle_event(const evq_event_t *ev);
+#ifdef EXTI_SLEEP_ON_EXIT
+static void button_isr(uint32_t line, void *arg);
+#endif
+
+// Every EXTI vector may post here, whatever its priority
+static evq_slot_t ev_slots[16];
+static evq_mp_t events;
 
 int main(void)
 {
 	gpio_config();
-	EXTI_config();
-	while(1);
+	evq_mp_init(&events, ev_slots, 16);
+
+	// Cycle counter for the event timestamps
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	pwr_init();
+
+#ifdef EXTI_SLEEP_ON_EXIT
+	exti_register(13, GPIOC, EXTI_FALLING, button_isr, 0, 1);
+	pwr_sleep_on_exit();                       //never returns
+#endif
+	//PC13 falling edge (button press) -> button_event(), EXTI15_10 priority 1
+	exti_register(13, GPIOC, EXTI_FALLING, button_event, 0, 1);
+
+#ifdef EXTI_STRESS
+	exti_stress_start();                       //results in exti_stress
+#endif
+#ifdef BITBAND_BENCH
+	bb_bench_run();                            //results in bb_bench
+#endif
+#ifdef LATENCY_TEST
+	lat_run();                                 //report on USART2, PA0 wired to PB12
+#endif
+	while(1)
+	{
+		(void)evq_mp_drain(&events, handle_event, 16);
+
+		// Sleep only if nothing arrived since the drain, a pending interrupt still wakes it
+		__disable_irq();
+		if (evq_mp_empty(&events))
+		{
+			pwr_idle(IDLE_MODE);
+		}
+		__enable_irq();                        //the waking interrupt runs here
+	}
 }
 
 static void gpio_config(void)
@@ -44,38 +111,26 @@ static void gpio_config(void)
 
 }
 
-static void EXTI_config(void)
+static void button_event(uint32_t line, void *arg)
 {
-	//Enabling clock for sysconfig
-	RCC->APB2ENR |= (1U << 14);
-	(void)RCC->APB2ENR;               // read-back to ensure clock is active
-
-	//configuring EXTI13 to GPIOC13
-	SYSCFG->EXTICR[3] &= ~(15U << 4);
-	SYSCFG->EXTICR[3] |= (2U << 4);
-
-	//Enabling the 13 line of EXTI
-	EXTI->IMR |= (1U << 13);
+	evq_event_t ev = { EV_BUTTON, (uint8_t)line, 0, 0, DWT->CYCCNT };
 
-	//detecting the falling edge
-	EXTI->FTSR |= (1U << 13);       //interrput occurs at falling edge
-	NVIC_config();
+	(void)evq_mp_put(&events, &ev);            // Full queue: counted in events.drops
 }
 
-static void NVIC_config(void)
+static void handle_event(const evq_event_t *ev)
 {
-	//settting the EXTI13 line interrput
-	NVIC->ISER[1] |= (1U << 8);
-
-	//setting the priority for EXTI13
-	NVIC->IP[40] |= (1U << 4);
-
+	if (ev->type == EV_BUTTON)
+	{
+		BB_PERIPH(GPIOA->ODR, 5) ^= 1U;        // Only PA5 is written back
+	}
 }
 
-void EXTI15_10_IRQHandler(void)
+#ifdef EXTI_SLEEP_ON_EXIT
+static void button_isr(uint32_t line, void *arg)
 {
-	GPIOA->ODR ^= (1U << 5);
-
-	//clearinf the pending EXTI Pending flag
-	EXTI->PR |= (1U << 13);
+	pwr_isr_enter();
+	BB_PERIPH(GPIOA->ODR, 5) ^= 1U;
+	pwr_isr_exit();
 }
+#endif
@@ -0,0 +1,153 @@
+/*
+ * Idle / power manager (see power.h)
+ */
+
+#include "power.h"
+
+volatile pwr_stats_t pwr_stats;
+
+static uint32_t mark;                  // CYCCNT at the last awake / asleep switch
+static uint8_t on_exit;                // pwr_sleep_on_exit() active
+static volatile uint32_t depth;        // ISR nesting in sleep-on-exit mode
+
+/*==========================================================*/
+/*
+ * After STOP the system runs on HSI: switch HSE, PLL and SYSCLK back as they were
+ */
+
+static void clocks_restore(uint32_t cr, uint32_t cfgr)
+{
+	if (cr & RCC_CR_HSEON)
+	{
+		RCC->CR |= RCC_CR_HSEON;
+		while (!(RCC->CR & RCC_CR_HSERDY)){}
+	}
+	if (cr & RCC_CR_PLLON)
+	{
+		RCC->CR |= RCC_CR_PLLON;
+		while (!(RCC->CR & RCC_CR_PLLRDY)){}
+	}
+	if ((cfgr & RCC_CFGR_SW) != RCC_CFGR_SW_HSI)
+	{
+		RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | (cfgr & RCC_CFGR_SW);
+		while ((RCC->CFGR & RCC_CFGR_SWS) != ((cfgr & RCC_CFGR_SW) << RCC_CFGR_SWS_Pos)){}
+	}
+}
+
+/*==========================================================*/
+
+void pwr_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+	(void)RCC->APB1ENR;
+
+	pwr_stats.awake_cyc = 0;
+	pwr_stats.sleep_cyc = 0;
+	pwr_stats.sleeps = 0;
+	pwr_stats.stops = 0;
+	on_exit = 0;
+	depth = 0;
+	mark = DWT->CYCCNT;
+}
+
+void pwr_idle(pwr_mode_t mode)
+{
+	uint32_t t = DWT->CYCCNT;
+
+	pwr_stats.awake_cyc += t - mark;
+	mark = t;
+
+	switch (mode)
+	{
+	case PWR_SLEEP_WFE:
+		SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+		// Already pending does not raise a new event: only sleep without one.
+		// A stale event register only ends the sleep early.
+		if (!(SCB->ICSR & SCB_ICSR_ISRPENDING_Msk))
+		{
+			__DSB();
+			__WFE();
+		}
+		pwr_stats.sleeps++;
+		break;
+
+	case PWR_STOP:
+	{
+		uint32_t cr = RCC->CR;
+		uint32_t cfgr = RCC->CFGR;
+
+		PWR->CR &= ~PWR_CR_PDDS;                   // Stop, not Standby
+		PWR->CR |= PWR_CR_LPDS;                    // Regulator in low-power mode
+		SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+		__DSB();
+		__WFI();
+		SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+		clocks_restore(cr, cfgr);
+		pwr_stats.stops++;
+		mark = DWT->CYCCNT;                        // CYCCNT stood still, nothing to add
+		return;
+	}
+
+	default:
+		__DSB();
+		__WFI();
+		pwr_stats.sleeps++;
+		break;
+	}
+
+	t = DWT->CYCCNT;
+	pwr_stats.sleep_cyc += t - mark;
+	mark = t;
+}
+
+/*==========================================================*/
+
+void pwr_sleep_on_exit(void)
+{
+	__disable_irq();
+	pwr_stats.awake_cyc += DWT->CYCCNT - mark;
+	mark = DWT->CYCCNT;
+	on_exit = 1;
+	SCB->SCR |= SCB_SCR_SLEEPONEXIT_Msk;
+	__DSB();
+	__enable_irq();
+
+	while (1)
+	{
+		__WFI();                                   // Thread code never runs again
+	}
+}
+
+void pwr_isr_enter(void)
+{
+	if (on_exit && (depth++ == 0U))
+	{
+		uint32_t t = DWT->CYCCNT;
+
+		pwr_stats.sleep_cyc += t - mark;
+		pwr_stats.sleeps++;
+		mark = t;
+	}
+}
+
+void pwr_isr_exit(void)
+{
+	if (on_exit && (--depth == 0U))
+	{
+		uint32_t t = DWT->CYCCNT;
+
+		pwr_stats.awake_cyc += t - mark;
+		mark = t;
+	}
+}
+
+uint32_t pwr_duty_permille(void)
+{
+	uint64_t awake = pwr_stats.awake_cyc;
+	uint64_t total = awake + pwr_stats.sleep_cyc;
+
+	return (total != 0U) ? (uint32_t)((awake * 1000U) / total) : 0U;
+}
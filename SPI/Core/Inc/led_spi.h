@@ -0,0 +1,43 @@
+// Header file for SPI driven LED outputs
+// WS2812 style LED strips and 74HC595 shift register chains on SPI1 MOSI,
+// streamed by DMA from a double buffer.
+
+#ifndef INC_LED_SPI_H_
+#define INC_LED_SPI_H_
+
+#include "stm32f4xx.h"
+
+/*
+    WS2812 : PA7 (SPI1_MOSI) -> DIN of the first LED
+             Every data bit becomes 4 SPI bits (0 -> 1000, 1 -> 1110).
+             SCK must be between 2.4 MHz and 4 MHz (T0H / T1H within spec).
+
+    74HC595: PA7 (MOSI) -> SER, PA5 (SCK) -> SRCLK, PA3 (CS) -> RCLK (latch)
+             Bytes are shifted out as they are, the last byte goes to the first chip.
+*/
+
+#define LED_SPI_MAX_PIXELS      144U          // WS2812 LEDs (74HC595 mode: up to 3x as many chips)
+#define LED_SPI_WS2812_HZ       4000000U      // Requested SCK for WS2812 timing
+#define LED_SPI_WS2812_MIN_HZ   2400000U
+#define LED_SPI_595_HZ          8000000U      // Requested SCK for 74HC595 chains
+#define LED_SPI_RESET_BYTES     150U          // >= 280 us low after a WS2812 frame at 4 MHz
+
+typedef enum
+{
+    LED_SPI_WS2812 = 0,
+    LED_SPI_595
+} led_spi_type_t;
+
+// Returns 0 on success, -1 if the SCK cannot meet the WS2812 timing or count is 0 or too large
+int led_spi_init(led_spi_type_t type, uint32_t count);
+
+// Frame being built by the application
+void led_spi_set_pixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b);   // WS2812
+void led_spi_set_byte(uint32_t index, uint8_t value);                      // 74HC595 chip outputs
+
+// Encode the frame into the idle buffer and start streaming it.
+// Only waits if the previous frame is still being sent.
+void led_spi_show(void);
+uint8_t led_spi_busy(void);
+
+#endif /* INC_LED_SPI_H_ */
@@ -0,0 +1,45 @@
+// Header file for the QUADSPI external NOR flash driver
+// This file only contains function declarations and chip parameters.
+// Actual logic is implemented in qspi.c (flash commands) and qspi_cmd.c (QUADSPI registers)
+
+#ifndef INC_QSPI_H_
+#define INC_QSPI_H_
+
+#include <stdint.h>
+
+/*
+    Flash chip parameters (W25Q128 style 16 MB quad NOR flash)
+    Change these for another chip.
+*/
+#define QSPI_FLASH_SIZE        (16U * 1024U * 1024U)
+#define QSPI_FLASH_SIZE_LOG2   24U
+#define QSPI_PAGE_SIZE         256U
+#define QSPI_SECTOR_SIZE       4096U
+
+#define QSPI_SCK_HZ            45000000U      // Requested QUADSPI clock (HCLK / (PRESCALER + 1))
+
+#define QSPI_MEM_BASE          0x90000000U    // Memory-mapped window
+
+// Read-ahead cache line for non-mapped (indirect) reads
+#define QSPI_CACHE_LINE        256U
+
+// Driver configuration
+void qspi_gpio_config(void);     // CLK, NCS, IO0..IO3
+void qspi_config(void);          // QUADSPI peripheral + quad enable in the flash
+
+// Indirect mode (CPU or DMA moves the data)
+void qspi_read(uint32_t addr, uint8_t *buf, uint32_t len);
+void qspi_read_dma(uint32_t addr, uint8_t *buf, uint32_t len);   // Bulk read, DMA2 Stream7
+void qspi_program(uint32_t addr, const uint8_t *buf, uint32_t len);
+void qspi_erase_sector(uint32_t addr);                          // 4 KB
+void qspi_erase_chip(void);
+
+// Read through the cache (small / sequential reads without memory mapping)
+void qspi_read_cached(uint32_t addr, uint8_t *buf, uint32_t len);
+void qspi_cache_invalidate(void);
+
+// Memory-mapped mode (execute in place, flash readable at QSPI_MEM_BASE)
+void qspi_memory_mapped_enable(void);
+void qspi_memory_mapped_disable(void);
+
+#endif /* INC_QSPI_H_ */
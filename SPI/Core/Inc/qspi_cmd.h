@@ -0,0 +1,33 @@
+// Header file for the QUADSPI command layer
+// One function per bus command shape (instruction, address, data phases).
+// qspi.c builds the flash commands on top of it; qspi_cmd.c drives the
+// QUADSPI registers, SPI/host/qspi_flash_model.c puts a flash model under it.
+
+#ifndef INC_QSPI_CMD_H_
+#define INC_QSPI_CMD_H_
+
+#include <stdint.h>
+
+void qspi_cmd_gpio_config(void);                          // CLK, NCS, IO0..IO3
+void qspi_cmd_init(void);                                 // Clock, prescaler, flash size (qspi.h)
+
+// Single line commands
+void qspi_cmd(uint8_t cmd);                               // Instruction only
+void qspi_cmd_addr(uint8_t cmd, uint32_t addr);           // Instruction + 24-bit address
+uint8_t qspi_cmd_read_reg(uint8_t cmd);                   // Instruction, 1 data byte in
+void qspi_cmd_write_reg(uint8_t cmd, uint8_t val);        // Instruction, 1 data byte out
+
+// Repeats a register read until (value & mask) == match
+void qspi_cmd_poll(uint8_t cmd, uint8_t mask, uint8_t match);
+
+// Quad data: 1-4-4 read with a mode byte and 4 dummy cycles, 1-1-4 write
+void qspi_cmd_read_quad(uint8_t cmd, uint8_t mode, uint32_t addr, uint8_t *buf, uint32_t len);
+void qspi_cmd_read_quad_dma(uint8_t cmd, uint8_t mode, uint32_t addr, uint8_t *buf, uint32_t len);
+void qspi_cmd_write_quad(uint8_t cmd, uint32_t addr, const uint8_t *buf, uint32_t len);
+
+// Memory-mapped mode with the same 1-4-4 read, left with an abort
+void qspi_cmd_mapped(uint8_t cmd, uint8_t mode);
+void qspi_cmd_abort(void);
+const uint8_t *qspi_cmd_window(void);                     // Flash address 0 while mapped
+
+#endif /* INC_QSPI_CMD_H_ */
@@ -7,10 +7,28 @@
 
 #include "stm32f4xx.h"
 
+// Requested SCK for SPI1 (master). The fastest divider not above this is used.
+#define SPI1_SCK_HZ      4000000U
+
+/*
+    Datasheet limits (STM32F446):
+    SPI1 / SPI4 (APB2) up to 45 Mbit/s
+    SPI2 / SPI3 (APB1) up to 22.5 Mbit/s
+*/
+#define SPI_APB2_MAX_HZ  45000000U
+#define SPI_APB1_MAX_HZ  22500000U
+
 // SPI configuration functions
 void spi1_config(void);      // Configure SPI1 as MASTER
 void spi2_config(void);      // Configure SPI2 as SLAVE
 
+// Baud rate (SCK) selection from the live bus clock
+// Target frequency is remembered per SPI so spi_clock_update() can re-apply it
+uint32_t spi_set_sck(SPI_TypeDef *SPIx, uint32_t target_hz);  // Pick fastest BR[2:0] <= target, returns achieved SCK
+uint32_t spi_get_sck(SPI_TypeDef *SPIx);                       // Current SCK from PCLK and BR[2:0]
+uint32_t spi_pclk_freq(SPI_TypeDef *SPIx);                     // PCLK of the bus the SPI sits on
+void spi_clock_update(void);                                   // Call after every SYSCLK / APB prescaler change
+
 // GPIO configuration for SPI pins
 void spi1_gpio_config(void); // Configure GPIO pins used by SPI1
 void spi2_gpio_config(void); // Configure GPIO pins used by SPI2
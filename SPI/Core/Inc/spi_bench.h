@@ -0,0 +1,29 @@
+// Header file for the SPI1 -> SPI2 loopback benchmark
+// Sweeps prescaler, CPOL/CPHA, frame size and transfer mode,
+// checks the data against a PRBS pattern and prints a table over USART2.
+// PRBS, result math and the table text live in spi_bench_fmt.h (register-free).
+
+#ifndef INC_SPI_BENCH_H_
+#define INC_SPI_BENCH_H_
+
+#include "stm32f4xx.h"
+#include "spi_bench_fmt.h"
+
+/*
+    Build with SPI_BENCH defined (Project Properties -> C/C++ Build -> Settings ->
+    MCU GCC Compiler -> Preprocessor) to run the benchmark instead of the demo.
+
+    Wiring: same loopback as the demo (PA5-PB13, PA6-PB14, PA7-PB15).
+    SPI2 uses software NSS in this mode, PB12 is not needed.
+*/
+
+#define SPI_BENCH_FRAMES     256U    // Frames per throughput run
+#define SPI_BENCH_LAT_RUNS   16U     // Single-frame transactions per latency run
+
+void spi_bench_run(void);     // Full sweep, prints the table
+
+// Single configuration (br = BR[2:0], mode_bits = CPOL | CPHA, frame16 = 0/1)
+void spi_bench_one(spi_bench_mode_t mode, uint32_t br, uint32_t mode_bits,
+                   uint32_t frame16, spi_bench_result_t *res);
+
+#endif /* INC_SPI_BENCH_H_ */
@@ -0,0 +1,49 @@
+// Header file for the register-free parts of the SPI benchmark
+// PRBS pattern, frame buffer access, result math and table formatting.
+// Nothing here touches a peripheral, so it also builds on the host (SPI/host).
+
+#ifndef INC_SPI_BENCH_FMT_H_
+#define INC_SPI_BENCH_FMT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum
+{
+    SPI_BENCH_POLL = 0,
+    SPI_BENCH_IRQ,
+    SPI_BENCH_DMA
+} spi_bench_mode_t;
+
+typedef struct
+{
+    uint32_t sck_hz;          // SCK from PCLK2 and BR[2:0]
+    uint32_t kbytes_s;        // Payload throughput (kB/s)
+    uint32_t gap_cycles;      // Average idle time between frames (core cycles)
+    uint32_t lat_min;         // Single-frame transaction latency (core cycles)
+    uint32_t lat_max;
+    uint32_t bit_errors;      // Both directions, against the PRBS pattern
+    uint8_t  timeout;         // 1 = transfer did not complete (e.g. overrun in IRQ mode)
+} spi_bench_result_t;
+
+// PRBS-15 (x^15 + x^14 + 1), returns the next 'bits' bits, state must be non-zero
+uint16_t prbs15(uint16_t *state, uint32_t bits);
+
+// Frame buffers hold bytes (frame16 = 0) or halfwords (frame16 = 1)
+void spi_bench_buf_put(uint16_t *buf, uint32_t i, uint16_t v, uint32_t frame16);
+uint16_t spi_bench_buf_get(const uint16_t *buf, uint32_t i, uint32_t frame16);
+
+// Bits that differ between two frame buffers of n frames
+uint32_t spi_bench_bit_errors(const uint16_t *a, const uint16_t *b, uint32_t n, uint32_t frame16);
+
+// kB/s and average gap per frame from a measured and an ideal cycle count
+void spi_bench_rates(spi_bench_result_t *res, uint32_t n, uint32_t bits, uint32_t core_hz,
+                     uint32_t cycles, uint32_t ideal);
+
+// Table lines (without '\n'), return value as snprintf()
+int spi_bench_fmt_title(char *buf, size_t len, uint32_t sysclk, uint32_t frames);
+int spi_bench_fmt_header(char *buf, size_t len);
+int spi_bench_fmt_row(char *buf, size_t len, spi_bench_mode_t mode, uint32_t frame16,
+                      uint32_t cp, uint32_t br, const spi_bench_result_t *res);
+
+#endif /* INC_SPI_BENCH_FMT_H_ */
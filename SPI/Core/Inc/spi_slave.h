@@ -0,0 +1,35 @@
+// Header file for the SPI2 slave register-map server
+// SPI2 exposes a register file to an external master.
+// Data bytes are moved by DMA, the CPU only runs once per transaction.
+
+#ifndef INC_SPI_SLAVE_H_
+#define INC_SPI_SLAVE_H_
+
+#include "stm32f4xx.h"
+
+/*
+    Frame format (MSB first, CPOL = 1, CPHA = 1, NSS low for the whole frame):
+
+    WRITE : [0 | addr(7)] [data0] [data1] ...
+    READ  : [1 | addr(7)] [dummy] [data0] [data1] ...
+
+    - Address auto-increments, past the end it wraps back to the start address
+    - For READ the byte after the command is a turnaround byte (slave sends 0xFF)
+    - Master must leave SPI2_CMD_GAP_US between the command byte and the data phase,
+      the data phase itself can run at full SCK speed
+*/
+#define SPI2_REGMAP_SIZE    128U
+#define SPI2_REGMAP_READ    0x80U
+#define SPI2_CMD_GAP_US     5U
+
+// Register file served to the master
+extern volatile uint8_t spi2_regs[SPI2_REGMAP_SIZE];
+
+// Called from the NSS rising edge ISR after a WRITE (start address, number of registers written:
+// bytes sent, at most SPI2_REGMAP_SIZE - addr once the address wrapped)
+typedef void (*spi2_regmap_cb_t)(uint8_t addr, uint8_t len);
+
+void spi2_regmap_init(void);                          // SPI2 slave + DMA + NSS (PB12) edge interrupt
+void spi2_regmap_set_callback(spi2_regmap_cb_t cb);   // Optional write notification
+
+#endif /* INC_SPI_SLAVE_H_ */
@@ -0,0 +1,14 @@
+// Header file for USART2 TX (ST-LINK virtual COM port)
+// Used to print results with printf()
+
+#ifndef INC_UART_H_
+#define INC_UART_H_
+
+#include "stm32f4xx.h"
+
+#define BAUDRATE     115200U
+
+void uart2_config(void);     // PA2 -> USART2_TX, 8N1
+void uart2_tx(char ch);      // Blocking transmit of one character
+
+#endif /* INC_UART_H_ */
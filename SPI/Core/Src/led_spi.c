@@ -0,0 +1,194 @@
+
+#include <string.h>
+#include "spi.h"
+#include "led_spi.h"
+#include "regclr.h"
+
+/*
+    SPI1 TX only, DMA2 Stream3 Channel3 -> SPI1_TX
+
+    Two encoded buffers: DMA streams one while led_spi_show() encodes
+    the next frame into the other, the CPU never waits on SPI bytes.
+
+    WS2812 encoding:
+    One colour byte -> one 32-bit word from ws_table[] (4 SPI bits per data bit).
+    The table is stored byte-reversed so a single word store lays the SPI bytes
+    out in transmit order (MSB pattern first) -> one load + one store per byte.
+    Every SPI byte ends with a 0 bit, so a short pause of SCK between bytes only
+    stretches a low phase, which WS2812 ignores.
+*/
+
+#define ENC_WORDS   ((LED_SPI_MAX_PIXELS * 3U) + ((LED_SPI_RESET_BYTES + 3U) / 4U))
+
+static uint8_t frame[LED_SPI_MAX_PIXELS * 3U];        // Built by the application
+static uint32_t enc[2][ENC_WORDS];                    // Encoded SPI bit-stream (double buffer)
+static uint32_t ws_table[256];
+
+static led_spi_type_t led_type;
+static uint32_t led_count;                            // LEDs or 595 chips
+static uint8_t next_buf;
+static volatile uint8_t dma_busy;
+
+/************************************************************/
+
+static void ws_table_init(void)
+{
+    for (uint32_t b = 0; b < 256U; b++)
+    {
+        uint32_t v = 0;
+
+        for (uint32_t bit = 0x80U; bit != 0U; bit >>= 1)
+        {
+            v = (v << 4) | ((b & bit) ? 0xEU : 0x8U);
+        }
+        ws_table[b] = __REV(v);
+    }
+}
+
+static void led_spi_dma_config(void)
+{
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+    (void)RCC->AHB1ENR;
+
+    DMA2_Stream3->CR &= ~(DMA_SxCR_EN);
+    while (DMA2_Stream3->CR & DMA_SxCR_EN){}
+
+    // Channel3, memory -> peripheral, byte wide, memory increment, transfer complete interrupt
+    DMA2_Stream3->PAR = (uint32_t)&SPI1->DR;
+    DMA2_Stream3->CR  = (3U << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 | DMA_SxCR_MINC |
+                        DMA_SxCR_DIR_0 | DMA_SxCR_TCIE;
+
+    NVIC_SetPriority(DMA2_Stream3_IRQn, 3);
+    NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+}
+
+/************************************************************/
+
+int led_spi_init(led_spi_type_t type, uint32_t count)
+{
+    uint32_t max = (type == LED_SPI_WS2812) ? LED_SPI_MAX_PIXELS : (LED_SPI_MAX_PIXELS * 3U);
+    uint32_t sck;
+
+    if ((count == 0U) || (count > max))
+    {
+        return -1;
+    }
+
+    led_type  = type;
+    led_count = count;
+    next_buf  = 0;
+    dma_busy  = 0;
+    memset(frame, 0, sizeof(frame));
+    memset(enc, 0, sizeof(enc));
+
+    spi1_gpio_config();
+    spi1_config();
+    cs_disable();
+
+    if (type == LED_SPI_WS2812)
+    {
+        ws_table_init();
+        sck = spi_set_sck(SPI1, LED_SPI_WS2812_HZ);
+
+        // Below this the "0" high time becomes too long for the LEDs
+        if (sck < LED_SPI_WS2812_MIN_HZ)
+        {
+            return -1;
+        }
+    }
+    else
+    {
+        spi_set_sck(SPI1, LED_SPI_595_HZ);
+    }
+
+    led_spi_dma_config();
+    SPI1->CR2 |= SPI_CR2_TXDMAEN;
+
+    return 0;
+}
+
+void led_spi_set_pixel(uint32_t index, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (index < led_count)
+    {
+        // WS2812 expects G, R, B
+        frame[(index * 3U) + 0U] = g;
+        frame[(index * 3U) + 1U] = r;
+        frame[(index * 3U) + 2U] = b;
+    }
+}
+
+void led_spi_set_byte(uint32_t index, uint8_t value)
+{
+    if (index < led_count)
+    {
+        frame[index] = value;
+    }
+}
+
+uint8_t led_spi_busy(void)
+{
+    return dma_busy;
+}
+
+void led_spi_show(void)
+{
+    uint32_t *dst = enc[next_buf];
+    uint32_t len;
+
+    // Encode while the other buffer may still be streaming
+    if (led_type == LED_SPI_WS2812)
+    {
+        uint32_t n = led_count * 3U;
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            dst[i] = ws_table[frame[i]];
+        }
+
+        // Reset (latch) time: MOSI low after the last LED
+        memset(&dst[n], 0, ((LED_SPI_RESET_BYTES + 3U) / 4U) * 4U);
+        len = (n * 4U) + LED_SPI_RESET_BYTES;
+    }
+    else
+    {
+        memcpy(dst, frame, led_count);
+        len = led_count;
+    }
+
+    // Previous frame must be out before the stream is restarted
+    while (dma_busy){}
+
+    if (led_type == LED_SPI_595)
+    {
+        cs_enable();                   // RCLK low, rising edge at the end latches the outputs
+    }
+
+    dma_stream_clear(DMA2, 3);         // Clear all Stream3 flags
+    DMA2_Stream3->M0AR = (uint32_t)dst;
+    DMA2_Stream3->NDTR = len;
+    dma_busy = 1;
+    DMA2_Stream3->CR |= DMA_SxCR_EN;
+
+    next_buf ^= 1U;
+}
+
+/************************************************************/
+
+void DMA2_Stream3_IRQHandler(void)
+{
+    if (DMA2->LISR & DMA_LISR_TCIF3)
+    {
+        reg_clear_w1(&DMA2->LIFCR, DMA_LIFCR_CTCIF3);
+
+        // Last bytes are still in the SPI shifter (at most 2 frames)
+        while (!(SPI1->SR & SPI_SR_TXE)){}
+        while (SPI1->SR & SPI_SR_BSY){}
+
+        if (led_type == LED_SPI_595)
+        {
+            cs_disable();
+        }
+        dma_busy = 0;
+    }
+}
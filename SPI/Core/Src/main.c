@@ -1,90 +1,208 @@
-#include "SPI.h"
+#include <string.h>
+#include "spi.h"
+#include "spi_slave.h"
+#include "spi_bench.h"
+#include "qspi.h"
+
+/*
+	SPI1 (MASTER) talks to the SPI2 register-map server (SLAVE).
+
+	Wiring on the board:
+	PA3 (CS)  -> PB12 (SPI2_NSS)
+	PA5 (SCK) -> PB13 (SPI2_SCK)
+	PA6 (MISO)-> PB14 (SPI2_MISO)
+	PA7 (MOSI)-> PB15 (SPI2_MOSI)
+*/
+
+static uint8_t spi1_transfer(uint8_t data);
+static void regmap_write(uint8_t addr, const uint8_t *data, uint8_t len);
+static void regmap_read(uint8_t addr, uint8_t *data, uint8_t len);
+static void cmd_gap(void);
+#ifdef QSPI_DEMO
+static void qspi_demo(void);
+
+/*
+	Last sector of the external flash, so a .qspi image at the start of the
+	chip (programmed with the external loader) survives the demo.
+*/
+#define QSPI_DEMO_ADDR   (QSPI_FLASH_SIZE - QSPI_SECTOR_SIZE)
+#define QSPI_DEMO_LEN    300U   //More than one page: the program splits at 256 bytes
+
+volatile uint8_t qspi_ok;       //Bit set per read path that matched: 0 indirect, 1 DMA, 2 cached, 3 mapped
+#endif
+
+volatile uint8_t regmap_ok;     // 1 = data read back matches what was written
 
 /************************************************************/
 
 int main(void)
 {
+#ifdef SPI_BENCH
+	//Benchmark build: sweep every SPI setting, results are printed on USART2
+	spi_bench_run();
+	while(1){}
+#endif
 
+#ifdef QSPI_DEMO
+	//External flash build: erase, program and read back one sector four ways
+	qspi_demo();
+	while(1){}
+#endif
 
-	//Configure GPIO pins for SPI2
-	spi2_gpio_config();
-	spi2_config();   //SPI2 as SLAVE
+	//Cycle counter for the command gap, independent of clock and optimisation
+	SystemCoreClockUpdate();
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	//SPI2 as SLAVE register-map server (GPIO, DMA and NSS interrupt)
+	spi2_regmap_init();
 
 
 	//Configure GPIO pins for SPI1
 	spi1_gpio_config();
 	spi1_config();   //SPI1 as MASTER
 
+	cs_disable();    //Idle: slave not selected
+
 
 
 	//Transmit data from SPI1 (MASTER)
 	uint8_t spi1_tx_data[3] = {0x77, 0x88, 0x99};
 
-	//Receive buffers
-	uint8_t spi2_rx_data[3];   //Data received by SPI2 (SLAVE)
-	uint8_t spi1_rx_data[3];   //Dummy data received by SPI1 (MASTER)
+	//Data read back from the SPI2 register file
+	uint8_t spi1_rx_data[3];
+
+
+	regmap_write(0x10, spi1_tx_data, 3);
+	regmap_read(0x10, spi1_rx_data, 3);
+
+
+	regmap_ok = 1;
+	for(uint8_t i = 0; i < 3; i++)
+	{
+		if((spi1_rx_data[i] != spi1_tx_data[i]) || (spi2_regs[0x10 + i] != spi1_tx_data[i]))
+		{
+			regmap_ok = 0;
+		}
+	}
 
 
-	SPI2->DR = 0xAA;           // Dummy preload
+	while(1)
+	{
+		/*
+		 * regmap_ok can be checked in the debugger (Live Expressions)
+		*/
+	}
+}
 
+/************************************************************/
 
+static uint8_t spi1_transfer(uint8_t data)
+{
+	//Wait until SPI1 transmit buffer is empty
+	while(!(SPI1->SR & SPI_SR_TXE)){}
+
+	SPI1->DR = data;
+
+	//SPI is full duplex so, every byte sent also receives one
+	while(!(SPI1->SR & SPI_SR_RXNE)){}
+
+	return SPI1->DR;
+}
+
+static void cmd_gap(void)
+{
 	/*
-		*CS is enabled here as good SPI practice, In this project, SPI2 uses Software NSS (SSM + SSI)
-		*so, CS is not strictly required for SPI2 to work.
+	 * Slave needs a few microseconds after the command byte
+	 * to point its DMA at the register (SPI2_CMD_GAP_US)
 	*/
-	cs_enable();
+	uint32_t cycles = (SystemCoreClock / 1000000U) * SPI2_CMD_GAP_US;
+	uint32_t t0 = DWT->CYCCNT;
 
+	while((DWT->CYCCNT - t0) < cycles){}
+}
 
+static void regmap_write(uint8_t addr, const uint8_t *data, uint8_t len)
+{
+	cs_enable();
 
-	for(uint8_t i = 0; i < 3; i++)
+	spi1_transfer(addr & ~SPI2_REGMAP_READ);
+	cmd_gap();
+
+	for(uint8_t i = 0; i < len; i++)
 	{
-		//Wait until SPI1 transmit buffer is empty
-		while(!(SPI1->SR & SPI_SR_TXE)){}
+		spi1_transfer(data[i]);
+	}
 
-		// Write data to SPI1 data register
-		//This also generates clock for SPI2
-		SPI1->DR = spi1_tx_data[i];
+	// Wait until SPI1 is no longer busy before releasing CS
+	while(SPI1->SR & SPI_SR_BSY){}
+	cs_disable();
+}
 
-		//Wait until SPI2 receives data
-		while(!(SPI2->SR & SPI_SR_RXNE)){}
+static void regmap_read(uint8_t addr, uint8_t *data, uint8_t len)
+{
+	cs_enable();
 
-		//Read received data from SPI2
-		spi2_rx_data[i] = SPI2->DR;
+	spi1_transfer(addr | SPI2_REGMAP_READ);
+	cmd_gap();
 
-		//SPI is full duplex so, SPI1 also receives data
-		while(!(SPI1->SR & SPI_SR_RXNE)){}
+	spi1_transfer(0xFF);       //Turnaround byte
 
-		//Read dummy data received by SPI1
-		spi1_rx_data[i] = SPI1->DR;
+	for(uint8_t i = 0; i < len; i++)
+	{
+		data[i] = spi1_transfer(0xFF);
 	}
 
-
-	cs_disable();
-
-	// Wait until SPI1 is no longer busy
 	while(SPI1->SR & SPI_SR_BSY){}
+	cs_disable();
+}
 
+/************************************************************/
 
+#ifdef QSPI_DEMO
+static uint8_t qspi_tx[QSPI_DEMO_LEN];
+static uint8_t qspi_rx[QSPI_DEMO_LEN];
 
-	/*
-		OVR (Overrun) safety clear.
-		Reading DR followed by SR clears possible OVR flag.
-		This is defensive coding for future scalability.
-	*/
-    volatile uint8_t temp;
-	temp = SPI1->DR;
-	temp = SPI1->SR;
+static uint8_t qspi_check(void)
+{
+	uint8_t ok = (memcmp(qspi_rx, qspi_tx, QSPI_DEMO_LEN) == 0);
 
-	temp = SPI2->DR;
-	temp = SPI2->SR;
+	memset(qspi_rx, 0, QSPI_DEMO_LEN);
+	return ok;
+}
 
+static void qspi_demo(void)
+{
+	qspi_gpio_config();
+	qspi_config();
 
-	while(1)
+	for(uint32_t i = 0; i < QSPI_DEMO_LEN; i++)
 	{
-		/*
-		 * we use LED or UArt to verifiy
-		*/
+		qspi_tx[i] = (uint8_t)((i * 7U) ^ (i >> 8));
 	}
-}
 
-/************************************************************/
+	qspi_erase_sector(QSPI_DEMO_ADDR);
+	qspi_program(QSPI_DEMO_ADDR, qspi_tx, QSPI_DEMO_LEN);
+
+	qspi_ok = 0;
+
+	qspi_read(QSPI_DEMO_ADDR, qspi_rx, QSPI_DEMO_LEN);
+	qspi_ok |= qspi_check() << 0;
+
+	qspi_read_dma(QSPI_DEMO_ADDR, qspi_rx, QSPI_DEMO_LEN);
+	qspi_ok |= qspi_check() << 1;
+
+	qspi_read_cached(QSPI_DEMO_ADDR, qspi_rx, QSPI_DEMO_LEN);
+	qspi_ok |= qspi_check() << 2;
+
+	//Plain CPU reads from the 0x90000000 window
+	qspi_memory_mapped_enable();
+	memcpy(qspi_rx, (const void *)(QSPI_MEM_BASE + QSPI_DEMO_ADDR), QSPI_DEMO_LEN);
+	qspi_ok |= qspi_check() << 3;
+
+	/*
+	 * qspi_ok == 0x0F: all four read paths returned what was programmed
+	 * (check it in the debugger, Live Expressions)
+	*/
+}
+#endif
@@ -0,0 +1,223 @@
+#include <string.h>
+#include "qspi.h"
+#include "qspi_cmd.h"
+
+/*
+    W25Q style flash commands on top of the QUADSPI command layer (qspi_cmd.h).
+    No register access here, SPI/host builds this file against a flash model.
+
+    Read command: 0xEB Fast Read Quad I/O (1-4-4), mode byte 0xFF, 4 dummy cycles.
+    The same command is used for indirect reads and for memory-mapped (XIP) mode.
+*/
+
+// Flash commands
+#define CMD_WRITE_ENABLE      0x06U
+#define CMD_READ_SR1          0x05U
+#define CMD_READ_SR2          0x35U
+#define CMD_WRITE_SR2         0x31U
+#define CMD_QUAD_READ         0xEBU
+#define CMD_QUAD_PROGRAM      0x32U
+#define CMD_SECTOR_ERASE      0x20U
+#define CMD_CHIP_ERASE        0xC7U
+
+#define SR1_WIP               (1U << 0)
+#define SR2_QE                (1U << 1)
+
+#define QUAD_READ_MODE_BYTE   0xFFU     // No continuous read mode, every access sends the instruction
+
+static uint8_t mapped;                                 // 1 = memory-mapped mode active
+static uint8_t cache_line[QSPI_CACHE_LINE];
+static uint32_t cache_tag = 0xFFFFFFFFU;               // Flash address of cache_line
+
+/************************************************************/
+
+void qspi_gpio_config(void)
+{
+    qspi_cmd_gpio_config();
+}
+
+// Wait for the end of a program / erase: SR1 until WIP = 0
+static void qspi_wait_ready(void)
+{
+    qspi_cmd_poll(CMD_READ_SR1, SR1_WIP, 0);
+}
+
+/*
+    Indirect commands cannot run while memory-mapped mode is active.
+    NOTE: code executing from QSPI_MEM_BASE must not call program / erase.
+*/
+static uint8_t qspi_enter_indirect(void)
+{
+    uint8_t was_mapped = mapped;
+
+    if (mapped)
+    {
+        qspi_memory_mapped_disable();
+    }
+    return was_mapped;
+}
+
+static void qspi_leave_indirect(uint8_t was_mapped)
+{
+    if (was_mapped)
+    {
+        qspi_memory_mapped_enable();
+    }
+}
+
+/************************************************************/
+
+void qspi_config(void)
+{
+    uint8_t sr2;
+
+    qspi_cmd_init();
+
+    // Quad mode has to be enabled once in the flash (non-volatile QE bit)
+    sr2 = qspi_cmd_read_reg(CMD_READ_SR2);
+    if (!(sr2 & SR2_QE))
+    {
+        qspi_cmd(CMD_WRITE_ENABLE);
+        qspi_cmd_write_reg(CMD_WRITE_SR2, sr2 | SR2_QE);
+        qspi_wait_ready();
+    }
+
+    mapped = 0;
+    qspi_cache_invalidate();
+}
+
+/************************************************************/
+
+void qspi_read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    uint8_t was_mapped;
+
+    if (len == 0U)
+    {
+        return;
+    }
+    was_mapped = qspi_enter_indirect();
+
+    qspi_cmd_read_quad(CMD_QUAD_READ, QUAD_READ_MODE_BYTE, addr, buf, len);
+
+    qspi_leave_indirect(was_mapped);
+}
+
+void qspi_read_dma(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    uint8_t was_mapped = qspi_enter_indirect();
+
+    qspi_cmd_read_quad_dma(CMD_QUAD_READ, QUAD_READ_MODE_BYTE, addr, buf, len);
+
+    qspi_leave_indirect(was_mapped);
+}
+
+void qspi_program(uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+    uint8_t was_mapped = qspi_enter_indirect();
+
+    qspi_cache_invalidate();
+
+    while (len != 0U)
+    {
+        // A page program must not cross a 256 byte page boundary (the flash wraps inside the page)
+        uint32_t room = QSPI_PAGE_SIZE - (addr % QSPI_PAGE_SIZE);
+        uint32_t n = (len < room) ? len : room;
+
+        qspi_cmd(CMD_WRITE_ENABLE);
+        qspi_cmd_write_quad(CMD_QUAD_PROGRAM, addr, buf, n);
+        qspi_wait_ready();
+
+        addr += n;
+        buf  += n;
+        len  -= n;
+    }
+
+    qspi_leave_indirect(was_mapped);
+}
+
+void qspi_erase_sector(uint32_t addr)
+{
+    uint8_t was_mapped = qspi_enter_indirect();
+
+    qspi_cache_invalidate();
+
+    qspi_cmd(CMD_WRITE_ENABLE);
+    qspi_cmd_addr(CMD_SECTOR_ERASE, addr & ~(QSPI_SECTOR_SIZE - 1U));
+    qspi_wait_ready();
+
+    qspi_leave_indirect(was_mapped);
+}
+
+void qspi_erase_chip(void)
+{
+    uint8_t was_mapped = qspi_enter_indirect();
+
+    qspi_cache_invalidate();
+
+    qspi_cmd(CMD_WRITE_ENABLE);
+    qspi_cmd(CMD_CHIP_ERASE);
+    qspi_wait_ready();
+
+    qspi_leave_indirect(was_mapped);
+}
+
+/************************************************************/
+
+/*
+    Read-ahead cache for indirect reads.
+    A miss fetches the whole aligned line, so following small or sequential
+    reads are served from RAM without a new command on the bus.
+*/
+void qspi_read_cached(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    // Mapped mode already has the QUADSPI prefetch, read the window directly
+    if (mapped)
+    {
+        memcpy(buf, qspi_cmd_window() + addr, len);
+        return;
+    }
+
+    while (len != 0U)
+    {
+        uint32_t line = addr & ~(QSPI_CACHE_LINE - 1U);
+        uint32_t off  = addr - line;
+        uint32_t n    = QSPI_CACHE_LINE - off;
+
+        if (n > len)
+        {
+            n = len;
+        }
+
+        if (cache_tag != line)
+        {
+            qspi_read_dma(line, cache_line, QSPI_CACHE_LINE);
+            cache_tag = line;
+        }
+
+        memcpy(buf, &cache_line[off], n);
+
+        addr += n;
+        buf  += n;
+        len  -= n;
+    }
+}
+
+void qspi_cache_invalidate(void)
+{
+    cache_tag = 0xFFFFFFFFU;
+}
+
+/************************************************************/
+
+void qspi_memory_mapped_enable(void)
+{
+    qspi_cmd_mapped(CMD_QUAD_READ, QUAD_READ_MODE_BYTE);
+    mapped = 1;
+}
+
+void qspi_memory_mapped_disable(void)
+{
+    qspi_cmd_abort();
+    mapped = 0;
+}
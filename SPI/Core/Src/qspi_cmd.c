@@ -0,0 +1,280 @@
+#include "stm32f4xx.h"
+#include "qspi.h"
+#include "qspi_cmd.h"
+#include "regclr.h"
+
+/*
+    QUADSPI bank 1 pins (Nucleo-F446RE, morpho connector):
+
+    PB2  -> QUADSPI_CLK     (AF9)
+    PB6  -> QUADSPI_BK1_NCS (AF10)
+    PC9  -> QUADSPI_BK1_IO0 (AF9)
+    PC10 -> QUADSPI_BK1_IO1 (AF9)
+    PC8  -> QUADSPI_BK1_IO2 (AF9)
+    PA1  -> QUADSPI_BK1_IO3 (AF9)
+
+    DMA2 Stream7 Channel3 -> QUADSPI (bulk reads)
+
+    Only the command shape lives here, the flash command codes are in qspi.c.
+*/
+
+// CCR field values
+#define LINES_1               1U
+#define LINES_4               3U
+#define ADSIZE_24BIT          2U
+#define FMODE_WRITE           0U
+#define FMODE_READ            1U
+#define FMODE_POLL            2U
+#define FMODE_MAPPED          3U
+
+#define CCR_INSTR(cmd)        ((uint32_t)(cmd) | (LINES_1 << QUADSPI_CCR_IMODE_Pos))
+#define CCR_ADDR(lines)       (((lines) << QUADSPI_CCR_ADMODE_Pos) | (ADSIZE_24BIT << QUADSPI_CCR_ADSIZE_Pos))
+#define CCR_DATA(lines)       ((lines) << QUADSPI_CCR_DMODE_Pos)
+#define CCR_FMODE(m)          ((uint32_t)(m) << QUADSPI_CCR_FMODE_Pos)
+
+// 1-4-4 read: address and mode byte on 4 lines, then 4 dummy cycles
+#define CCR_QUAD_READ(cmd)    (CCR_INSTR(cmd) | CCR_ADDR(LINES_4) | \
+                               (LINES_4 << QUADSPI_CCR_ABMODE_Pos) | (4U << QUADSPI_CCR_DCYC_Pos) | \
+                               CCR_DATA(LINES_4))
+
+#define QSPI_DR8              (*(volatile uint8_t *)&QUADSPI->DR)
+
+/************************************************************/
+
+void qspi_cmd_gpio_config(void)
+{
+    RCC->AHB1ENR |= (RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_GPIOBEN | RCC_AHB1ENR_GPIOCEN);
+    (void)RCC->AHB1ENR;
+
+    // PA1 -> AF9
+    GPIOA->MODER   &= ~(3U << 2);
+    GPIOA->MODER   |=  (2U << 2);
+    GPIOA->OSPEEDR |=  (3U << 2);
+    GPIOA->AFR[0]  &= ~(15U << 4);
+    GPIOA->AFR[0]  |=  (9U << 4);
+
+    // PB2 -> AF9, PB6 -> AF10
+    GPIOB->MODER   &= ~((3U << 4) | (3U << 12));
+    GPIOB->MODER   |=  ((2U << 4) | (2U << 12));
+    GPIOB->OSPEEDR |=  ((3U << 4) | (3U << 12));
+    GPIOB->AFR[0]  &= ~((15U << 8) | (15U << 24));
+    GPIOB->AFR[0]  |=  ((9U << 8) | (10U << 24));
+
+    // NCS pull-up: chip stays deselected while QUADSPI is off
+    GPIOB->PUPDR   &= ~(3U << 12);
+    GPIOB->PUPDR   |=  (1U << 12);
+
+    // PC8, PC9, PC10 -> AF9
+    GPIOC->MODER   &= ~((3U << 16) | (3U << 18) | (3U << 20));
+    GPIOC->MODER   |=  ((2U << 16) | (2U << 18) | (2U << 20));
+    GPIOC->OSPEEDR |=  ((3U << 16) | (3U << 18) | (3U << 20));
+    GPIOC->AFR[1]  &= ~((15U << 0) | (15U << 4) | (15U << 8));
+    GPIOC->AFR[1]  |=  ((9U << 0) | (9U << 4) | (9U << 8));
+}
+
+void qspi_cmd_init(void)
+{
+    uint32_t presc;
+
+    RCC->AHB3ENR |= RCC_AHB3ENR_QSPIEN;
+    (void)RCC->AHB3ENR;
+
+    QUADSPI->CR &= ~(QUADSPI_CR_EN);
+
+    // QUADSPI is clocked from HCLK: SCK = HCLK / (PRESCALER + 1)
+    SystemCoreClockUpdate();
+    presc = ((SystemCoreClock + QSPI_SCK_HZ - 1U) / QSPI_SCK_HZ) - 1U;
+    if (presc > 255U)
+    {
+        presc = 255U;
+    }
+
+    // Flash size 2^(FSIZE+1), NCS high for at least 2 cycles between commands, clock mode 0
+    QUADSPI->DCR = ((QSPI_FLASH_SIZE_LOG2 - 1U) << QUADSPI_DCR_FSIZE_Pos) | (1U << QUADSPI_DCR_CSHT_Pos);
+
+    // Sample shift by half a cycle for margin at high SCK, FIFO threshold 1 byte
+    QUADSPI->CR = (presc << QUADSPI_CR_PRESCALER_Pos) | QUADSPI_CR_SSHIFT;
+
+    QUADSPI->CR |= QUADSPI_CR_EN;
+}
+
+/************************************************************/
+
+static void qspi_wait_idle(void)
+{
+    while (QUADSPI->SR & QUADSPI_SR_BUSY){}
+}
+
+static void qspi_wait_tc(void)
+{
+    while (!(QUADSPI->SR & QUADSPI_SR_TCF)){}
+    QUADSPI->FCR = QUADSPI_FCR_CTCF;       // Write 1 to clear
+}
+
+// Instruction only (starts when CCR is written)
+void qspi_cmd(uint8_t cmd)
+{
+    qspi_wait_idle();
+    QUADSPI->CCR = CCR_INSTR(cmd) | CCR_FMODE(FMODE_WRITE);
+    qspi_wait_tc();
+}
+
+// Instruction + 24-bit address (starts when AR is written)
+void qspi_cmd_addr(uint8_t cmd, uint32_t addr)
+{
+    qspi_wait_idle();
+    QUADSPI->CCR = CCR_INSTR(cmd) | CCR_ADDR(LINES_1) | CCR_FMODE(FMODE_WRITE);
+    QUADSPI->AR  = addr;
+    qspi_wait_tc();
+}
+
+uint8_t qspi_cmd_read_reg(uint8_t cmd)
+{
+    uint8_t val;
+
+    qspi_wait_idle();
+    QUADSPI->DLR = 0;
+    QUADSPI->CCR = CCR_INSTR(cmd) | CCR_DATA(LINES_1) | CCR_FMODE(FMODE_READ);
+    while ((QUADSPI->SR & QUADSPI_SR_FLEVEL) == 0U){}
+    val = QSPI_DR8;
+    qspi_wait_tc();
+
+    return val;
+}
+
+void qspi_cmd_write_reg(uint8_t cmd, uint8_t val)
+{
+    qspi_wait_idle();
+    QUADSPI->DLR = 0;
+    QUADSPI->CCR = CCR_INSTR(cmd) | CCR_DATA(LINES_1) | CCR_FMODE(FMODE_WRITE);
+    QSPI_DR8 = val;
+    qspi_wait_tc();
+}
+
+/*
+    Automatic polling mode: the hardware reads the register until it matches, no CPU reads.
+*/
+void qspi_cmd_poll(uint8_t cmd, uint8_t mask, uint8_t match)
+{
+    qspi_wait_idle();
+
+    QUADSPI->PSMKR = mask;
+    QUADSPI->PSMAR = match;
+    QUADSPI->PIR   = 0x10;
+    QUADSPI->DLR   = 0;
+    QUADSPI->CR   |= QUADSPI_CR_APMS;              // Stop on first match
+    QUADSPI->CCR   = CCR_INSTR(cmd) | CCR_DATA(LINES_1) | CCR_FMODE(FMODE_POLL);
+
+    while (!(QUADSPI->SR & QUADSPI_SR_SMF)){}
+    QUADSPI->FCR = QUADSPI_FCR_CSMF;
+}
+
+/************************************************************/
+
+void qspi_cmd_read_quad(uint8_t cmd, uint8_t mode, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (len == 0U)
+    {
+        return;
+    }
+
+    qspi_wait_idle();
+    QUADSPI->DLR = len - 1U;
+    QUADSPI->CCR = CCR_QUAD_READ(cmd) | CCR_FMODE(FMODE_READ);
+    QUADSPI->ABR = mode;
+    QUADSPI->AR  = addr;                           // Starts the read
+
+    while (len--)
+    {
+        while ((QUADSPI->SR & QUADSPI_SR_FLEVEL) == 0U){}
+        *buf++ = QSPI_DR8;
+    }
+    qspi_wait_tc();
+}
+
+void qspi_cmd_read_quad_dma(uint8_t cmd, uint8_t mode, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+    (void)RCC->AHB1ENR;
+
+    while (len != 0U)
+    {
+        // NDTR is 16 bits wide
+        uint32_t chunk = (len > 0xFFFFU) ? 0xFFFFU : len;
+
+        DMA2_Stream7->CR &= ~(DMA_SxCR_EN);
+        while (DMA2_Stream7->CR & DMA_SxCR_EN){}
+        dma_stream_clear(DMA2, 7);                 // Clear all Stream7 flags
+
+        // Channel3, peripheral -> memory, byte wide, memory increment
+        DMA2_Stream7->PAR  = (uint32_t)&QUADSPI->DR;
+        DMA2_Stream7->M0AR = (uint32_t)buf;
+        DMA2_Stream7->NDTR = chunk;
+        DMA2_Stream7->CR   = (3U << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 | DMA_SxCR_MINC;
+        DMA2_Stream7->CR  |= DMA_SxCR_EN;
+
+        qspi_wait_idle();
+        QUADSPI->CR |= QUADSPI_CR_DMAEN;
+        QUADSPI->DLR = chunk - 1U;
+        QUADSPI->CCR = CCR_QUAD_READ(cmd) | CCR_FMODE(FMODE_READ);
+        QUADSPI->ABR = mode;
+        QUADSPI->AR  = addr;
+
+        while (!(DMA2->HISR & DMA_HISR_TCIF7)){}
+        qspi_wait_tc();
+        QUADSPI->CR &= ~(QUADSPI_CR_DMAEN);
+
+        addr += chunk;
+        buf  += chunk;
+        len  -= chunk;
+    }
+}
+
+void qspi_cmd_write_quad(uint8_t cmd, uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+    if (len == 0U)
+    {
+        return;
+    }
+
+    qspi_wait_idle();
+    QUADSPI->DLR = len - 1U;
+    QUADSPI->CCR = CCR_INSTR(cmd) | CCR_ADDR(LINES_1) | CCR_DATA(LINES_4) | CCR_FMODE(FMODE_WRITE);
+    QUADSPI->AR  = addr;
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        while (!(QUADSPI->SR & QUADSPI_SR_FTF)){}
+        QSPI_DR8 = buf[i];                         // First byte starts the command
+    }
+    qspi_wait_tc();
+}
+
+/************************************************************/
+
+void qspi_cmd_mapped(uint8_t cmd, uint8_t mode)
+{
+    qspi_wait_idle();
+
+    // Release NCS after 256 idle cycles so the flash can go to standby
+    QUADSPI->LPTR = 0xFF;
+    QUADSPI->CR  |= QUADSPI_CR_TCEN;
+
+    QUADSPI->ABR = mode;
+    QUADSPI->CCR = CCR_QUAD_READ(cmd) | CCR_FMODE(FMODE_MAPPED);
+}
+
+void qspi_cmd_abort(void)
+{
+    // Abort is the only way out of memory-mapped mode
+    QUADSPI->CR |= QUADSPI_CR_ABORT;
+    while (QUADSPI->CR & QUADSPI_CR_ABORT){}
+    qspi_wait_idle();
+
+    QUADSPI->CR &= ~(QUADSPI_CR_TCEN);
+}
+
+const uint8_t *qspi_cmd_window(void)
+{
+    return (const uint8_t *)QSPI_MEM_BASE;
+}
@@ -52,8 +52,11 @@ void spi1_config(void)
     // Disable SPI before configuration
     SPI1->CR1 &= ~(SPI_CR1_SPE);
 
-    // Baud rate (Master controls SPI clock)
-    SPI1->CR1 |= (1U << 3);
+    /*
+        Baud rate (Master controls SPI clock)
+        BR[2:0] is picked from the real APB2 clock instead of a fixed fPCLK/4
+    */
+    spi_set_sck(SPI1, SPI1_SCK_HZ);
 
     // CPOL = 1, CPHA = 1 (must match slave)
     SPI1->CR1 |= (SPI_CR1_CPOL);
@@ -172,3 +175,111 @@ void cs_disable(void)
     */
     GPIOA->ODR |= (1U << 3);
 }
+
+/************************************************************/
+
+/*
+    Baud rate selection
+
+    SCK = fPCLK / 2^(BR+1), BR = 0..7  ->  fPCLK/2 ... fPCLK/256
+    SPI1 / SPI4 are clocked from APB2, SPI2 / SPI3 from APB1.
+
+    The requested frequency of every SPI is kept in spi_target_hz[],
+    so after SYSCLK or the APB prescalers change spi_clock_update()
+    recomputes all dividers and each SPI runs again at the fastest
+    rate that does not exceed its target.
+*/
+
+static uint32_t spi_target_hz[4];   // 0 = SPI not configured through spi_set_sck()
+
+static int spi_index(SPI_TypeDef *SPIx)
+{
+    if (SPIx == SPI1) return 0;
+    if (SPIx == SPI2) return 1;
+    if (SPIx == SPI3) return 2;
+    if (SPIx == SPI4) return 3;
+    return -1;
+}
+
+static SPI_TypeDef *const spi_table[4] = {SPI1, SPI2, SPI3, SPI4};
+
+uint32_t spi_pclk_freq(SPI_TypeDef *SPIx)
+{
+    // Re-read RCC so a clock change done elsewhere is seen here
+    SystemCoreClockUpdate();
+
+    if ((SPIx == SPI1) || (SPIx == SPI4))
+    {
+        return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+    }
+    return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
+
+static void spi_write_br(SPI_TypeDef *SPIx, uint32_t br)
+{
+    uint32_t spe = SPIx->CR1 & SPI_CR1_SPE;
+
+    /*
+        BR must not change in the middle of a frame.
+        If SPI is running, wait for the current transfer and stop it first.
+    */
+    if (spe)
+    {
+        while (SPIx->SR & SPI_SR_BSY){}
+        SPIx->CR1 &= ~(SPI_CR1_SPE);
+    }
+
+    SPIx->CR1 = (SPIx->CR1 & ~(SPI_CR1_BR)) | (br << SPI_CR1_BR_Pos);
+
+    SPIx->CR1 |= spe;
+}
+
+uint32_t spi_set_sck(SPI_TypeDef *SPIx, uint32_t target_hz)
+{
+    int idx = spi_index(SPIx);
+    uint32_t pclk = spi_pclk_freq(SPIx);
+    uint32_t limit = ((SPIx == SPI1) || (SPIx == SPI4)) ? SPI_APB2_MAX_HZ : SPI_APB1_MAX_HZ;
+    uint32_t br = 0;
+
+    if (idx < 0)
+    {
+        return 0;
+    }
+
+    spi_target_hz[idx] = target_hz;
+
+    // Never go above what the peripheral is specified for
+    if (target_hz > limit)
+    {
+        target_hz = limit;
+    }
+
+    // Smallest divider whose result is not above the target, /256 if none fits
+    while ((br < 7U) && ((pclk >> (br + 1U)) > target_hz))
+    {
+        br++;
+    }
+
+    spi_write_br(SPIx, br);
+
+    return pclk >> (br + 1U);
+}
+
+uint32_t spi_get_sck(SPI_TypeDef *SPIx)
+{
+    uint32_t br = (SPIx->CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos;
+
+    return spi_pclk_freq(SPIx) >> (br + 1U);
+}
+
+void spi_clock_update(void)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        // Only masters that were set up with a target frequency
+        if ((spi_target_hz[i] != 0U) && (spi_table[i]->CR1 & SPI_CR1_MSTR))
+        {
+            spi_set_sck(spi_table[i], spi_target_hz[i]);
+        }
+    }
+}
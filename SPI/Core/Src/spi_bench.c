@@ -0,0 +1,320 @@
+
+#include <stdio.h>
+#include "spi.h"
+#include "uart.h"
+#include "spi_bench.h"
+#include "regclr.h"
+
+/*
+    SPI1 (MASTER, device under test) -> SPI2 (SLAVE, always DMA)
+
+    The slave side is served by DMA in every run so it never limits the master.
+    Only the master side changes between polling, interrupt and DMA.
+
+    DMA1 Stream3 Channel0 -> SPI2_RX      DMA2 Stream2 Channel3 -> SPI1_RX
+    DMA1 Stream4 Channel0 -> SPI2_TX      DMA2 Stream3 Channel3 -> SPI1_TX
+
+    Time is measured with DWT->CYCCNT (core clock cycles).
+*/
+
+#define N_FRAMES    SPI_BENCH_FRAMES
+
+/*
+    CPU access to the master DR. The host register model (SPI/host/regmodel)
+    defines these to see the reads and writes (a read clears RXNE).
+*/
+#ifndef SPI_DR_READ
+#define SPI_DR_READ(spi)        ((spi)->DR)
+#define SPI_DR_WRITE(spi, v)    ((spi)->DR = (v))
+#endif
+
+// Frame buffers, accessed as bytes or halfwords depending on the frame size
+static uint16_t m_tx[N_FRAMES], m_rx[N_FRAMES];
+static uint16_t s_tx[N_FRAMES], s_rx[N_FRAMES];
+
+// State for the interrupt driven master
+static volatile uint32_t irq_tx_idx, irq_rx_idx, irq_len, irq_frame16;
+
+/************************************************************/
+
+static void dwt_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/************************************************************/
+
+static void dma_stream_stop(DMA_Stream_TypeDef *s)
+{
+    s->CR &= ~(DMA_SxCR_EN);
+    while (s->CR & DMA_SxCR_EN){}
+}
+
+static void dma_clear_flags(void)
+{
+    // Write 1 to clear every flag of the four streams used here
+    dma_stream_clear(DMA1, 3);
+    dma_stream_clear(DMA1, 4);
+    dma_stream_clear(DMA2, 2);
+    dma_stream_clear(DMA2, 3);
+}
+
+static void dma_stream_setup(DMA_Stream_TypeDef *s, uint32_t chsel, volatile uint32_t *dr,
+                             void *mem, uint32_t n, uint32_t to_periph, uint32_t frame16)
+{
+    uint32_t size = frame16 ? (DMA_SxCR_PSIZE_0 | DMA_SxCR_MSIZE_0) : 0U;
+
+    dma_stream_stop(s);
+
+    s->PAR  = (uint32_t)dr;
+    s->M0AR = (uint32_t)mem;
+    s->NDTR = n;
+    s->CR   = (chsel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 | DMA_SxCR_MINC | size |
+              (to_periph ? DMA_SxCR_DIR_0 : 0U);
+}
+
+/************************************************************/
+
+static void spi_reset_both(void)
+{
+    RCC->APB2RSTR |= RCC_APB2RSTR_SPI1RST;
+    RCC->APB2RSTR &= ~(RCC_APB2RSTR_SPI1RST);
+    RCC->APB1RSTR |= RCC_APB1RSTR_SPI2RST;
+    RCC->APB1RSTR &= ~(RCC_APB1RSTR_SPI2RST);
+}
+
+/*
+    Slave first: its TX DMA preloads the first frame before the master starts clocking.
+    SSM = 1, SSI = 0 -> slave always selected.
+*/
+static void slave_start(uint32_t mode_bits, uint32_t frame16, uint32_t n)
+{
+    SPI2->CR1 = mode_bits | (frame16 ? SPI_CR1_DFF : 0U) | SPI_CR1_SSM;
+
+    dma_stream_setup(DMA1_Stream3, 0U, &SPI2->DR, s_rx, n, 0U, frame16);
+    dma_stream_setup(DMA1_Stream4, 0U, &SPI2->DR, s_tx, n, 1U, frame16);
+    dma_clear_flags();
+
+    SPI2->CR2 |= SPI_CR2_RXDMAEN;
+    DMA1_Stream3->CR |= DMA_SxCR_EN;
+    DMA1_Stream4->CR |= DMA_SxCR_EN;
+    SPI2->CR2 |= SPI_CR2_TXDMAEN;
+
+    SPI2->CR1 |= SPI_CR1_SPE;
+}
+
+static void master_setup(uint32_t br, uint32_t mode_bits, uint32_t frame16)
+{
+    SPI1->CR1 = (br << SPI_CR1_BR_Pos) | mode_bits | (frame16 ? SPI_CR1_DFF : 0U) |
+                SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI;
+    SPI1->CR1 |= SPI_CR1_SPE;
+}
+
+/*
+    Runs one master transfer of n frames, returns elapsed cycles.
+    *timeout is set when the transfer did not finish within 'limit' cycles.
+*/
+static uint32_t master_transfer(spi_bench_mode_t mode, uint32_t n, uint32_t frame16,
+                                uint32_t limit, uint8_t *timeout)
+{
+    uint32_t t0, t1;
+
+    if (mode == SPI_BENCH_DMA)
+    {
+        dma_stream_setup(DMA2_Stream2, 3U, &SPI1->DR, m_rx, n, 0U, frame16);
+        dma_stream_setup(DMA2_Stream3, 3U, &SPI1->DR, m_tx, n, 1U, frame16);
+        dma_clear_flags();
+        DMA2_Stream2->CR |= DMA_SxCR_EN;
+        DMA2_Stream3->CR |= DMA_SxCR_EN;
+    }
+    else if (mode == SPI_BENCH_IRQ)
+    {
+        irq_tx_idx = 0;
+        irq_rx_idx = 0;
+        irq_len = n;
+        irq_frame16 = frame16;
+    }
+
+    t0 = DWT->CYCCNT;
+
+    switch (mode)
+    {
+    case SPI_BENCH_POLL:
+        for (uint32_t i = 0; (i < n) && !*timeout; i++)
+        {
+            while (!(SPI1->SR & SPI_SR_TXE)){}
+            SPI_DR_WRITE(SPI1, spi_bench_buf_get(m_tx, i, frame16));
+
+            while (!(SPI1->SR & SPI_SR_RXNE))
+            {
+                if ((DWT->CYCCNT - t0) > limit) { *timeout = 1; break; }
+            }
+            spi_bench_buf_put(m_rx, i, (uint16_t)SPI_DR_READ(SPI1), frame16);
+        }
+        break;
+
+    case SPI_BENCH_IRQ:
+        SPI1->CR2 |= (SPI_CR2_RXNEIE | SPI_CR2_TXEIE);
+        while (irq_rx_idx < n)
+        {
+            if ((DWT->CYCCNT - t0) > limit) { *timeout = 1; break; }
+        }
+        break;
+
+    case SPI_BENCH_DMA:
+        SPI1->CR2 |= (SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+        while (!(DMA2->LISR & DMA_LISR_TCIF2))
+        {
+            if ((DWT->CYCCNT - t0) > limit) { *timeout = 1; break; }
+        }
+        break;
+    }
+
+    t1 = DWT->CYCCNT;
+
+    SPI1->CR2 = 0;
+    while (SPI1->SR & SPI_SR_BSY)
+    {
+        if ((DWT->CYCCNT - t0) > limit) { *timeout = 1; break; }
+    }
+
+    dma_stream_stop(DMA2_Stream2);
+    dma_stream_stop(DMA2_Stream3);
+
+    return t1 - t0;
+}
+
+void SPI1_IRQHandler(void)
+{
+    // Read first so RX never overruns while TX is refilled
+    if (SPI1->SR & SPI_SR_RXNE)
+    {
+        spi_bench_buf_put(m_rx, irq_rx_idx, (uint16_t)SPI_DR_READ(SPI1), irq_frame16);
+        irq_rx_idx++;
+    }
+
+    if ((SPI1->CR2 & SPI_CR2_TXEIE) && (SPI1->SR & SPI_SR_TXE))
+    {
+        if (irq_tx_idx < irq_len)
+        {
+            SPI_DR_WRITE(SPI1, spi_bench_buf_get(m_tx, irq_tx_idx, irq_frame16));
+            irq_tx_idx++;
+        }
+        else
+        {
+            SPI1->CR2 &= ~(SPI_CR2_TXEIE);
+        }
+    }
+
+    if (irq_rx_idx >= irq_len)
+    {
+        SPI1->CR2 &= ~(SPI_CR2_RXNEIE | SPI_CR2_TXEIE);
+    }
+}
+
+/************************************************************/
+
+void spi_bench_one(spi_bench_mode_t mode, uint32_t br, uint32_t mode_bits,
+                   uint32_t frame16, spi_bench_result_t *res)
+{
+    uint32_t bits = frame16 ? 16U : 8U;
+    uint32_t pclk2 = spi_pclk_freq(SPI1);
+    uint32_t cyc_per_bit = (SystemCoreClock / pclk2) << (br + 1U);
+    uint32_t ideal = N_FRAMES * bits * cyc_per_bit;
+    uint32_t limit = (ideal * 4U) + 200000U;
+    uint16_t seed_m = 0x1234U, seed_s = 0x4321U;
+    uint32_t cycles;
+
+    res->sck_hz = pclk2 >> (br + 1U);
+    res->timeout = 0;
+    res->bit_errors = 0;
+
+    // Fresh PRBS data in both directions, stale data in the RX buffers
+    for (uint32_t i = 0; i < N_FRAMES; i++)
+    {
+        spi_bench_buf_put(m_tx, i, prbs15(&seed_m, bits), frame16);
+        spi_bench_buf_put(s_tx, i, prbs15(&seed_s, bits), frame16);
+        spi_bench_buf_put(m_rx, i, 0, frame16);
+        spi_bench_buf_put(s_rx, i, 0, frame16);
+    }
+
+    /* Throughput and inter-frame gap */
+    spi_reset_both();
+    slave_start(mode_bits, frame16, N_FRAMES);
+    master_setup(br, mode_bits, frame16);
+
+    cycles = master_transfer(mode, N_FRAMES, frame16, limit, &res->timeout);
+
+    spi_bench_rates(res, N_FRAMES, bits, SystemCoreClock, cycles, ideal);
+
+    // Master received slave data, slave received master data
+    res->bit_errors  = spi_bench_bit_errors(m_tx, s_rx, N_FRAMES, frame16);
+    res->bit_errors += spi_bench_bit_errors(s_tx, m_rx, N_FRAMES, frame16);
+
+    /* Single-frame transaction latency */
+    res->lat_min = 0xFFFFFFFFU;
+    res->lat_max = 0;
+
+    for (uint32_t r = 0; (r < SPI_BENCH_LAT_RUNS) && !res->timeout; r++)
+    {
+        spi_reset_both();
+        slave_start(mode_bits, frame16, 1U);
+        master_setup(br, mode_bits, frame16);
+
+        cycles = master_transfer(mode, 1U, frame16, limit, &res->timeout);
+
+        if (cycles < res->lat_min) res->lat_min = cycles;
+        if (cycles > res->lat_max) res->lat_max = cycles;
+    }
+
+    spi_reset_both();
+}
+
+void spi_bench_run(void)
+{
+    spi_bench_result_t res;
+    char line[128];
+
+    dwt_init();
+    uart2_config();
+
+    spi1_gpio_config();
+    spi2_gpio_config();
+
+    RCC->APB2ENR |= RCC_APB2ENR_SPI1EN;
+    RCC->APB1ENR |= RCC_APB1ENR_SPI2EN;
+    RCC->AHB1ENR |= (RCC_AHB1ENR_DMA1EN | RCC_AHB1ENR_DMA2EN);
+    (void)RCC->AHB1ENR;
+
+    NVIC_SetPriority(SPI1_IRQn, 1);
+    NVIC_EnableIRQ(SPI1_IRQn);
+
+    spi_bench_fmt_title(line, sizeof(line), SystemCoreClock, N_FRAMES);
+    printf("\n%s\n", line);
+    spi_bench_fmt_header(line, sizeof(line));
+    printf("%s\n", line);
+
+    for (uint32_t mode = SPI_BENCH_POLL; mode <= SPI_BENCH_DMA; mode++)
+    {
+        for (uint32_t frame16 = 0; frame16 < 2U; frame16++)
+        {
+            for (uint32_t cp = 0; cp < 4U; cp++)
+            {
+                // cp bit1 = CPOL, bit0 = CPHA
+                uint32_t mode_bits = ((cp & 2U) ? SPI_CR1_CPOL : 0U) | ((cp & 1U) ? SPI_CR1_CPHA : 0U);
+
+                for (uint32_t br = 0; br < 8U; br++)
+                {
+                    spi_bench_one((spi_bench_mode_t)mode, br, mode_bits, frame16, &res);
+
+                    spi_bench_fmt_row(line, sizeof(line), (spi_bench_mode_t)mode, frame16, cp, br, &res);
+                    printf("%s\n", line);
+                }
+            }
+        }
+    }
+
+    printf("done\n");
+}
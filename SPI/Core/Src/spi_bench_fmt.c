@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include "spi_bench_fmt.h"
+
+/*
+    Register-free half of spi_bench.c.
+    Only <stdio.h> and <stdint.h>, so the same file is compiled by SPI/host/Makefile.
+*/
+
+static const char *const mode_name[] = {"POLL", "IRQ", "DMA"};
+
+/************************************************************/
+
+/*
+    PRBS-15 (x^15 + x^14 + 1), one new bit per step
+*/
+uint16_t prbs15(uint16_t *state, uint32_t bits)
+{
+    uint16_t out = 0;
+
+    for (uint32_t i = 0; i < bits; i++)
+    {
+        uint16_t s = *state;
+        uint16_t b = ((s >> 14) ^ (s >> 13)) & 1U;
+
+        *state = ((s << 1) | b) & 0x7FFFU;
+        out = (out << 1) | b;
+    }
+    return out;
+}
+
+void spi_bench_buf_put(uint16_t *buf, uint32_t i, uint16_t v, uint32_t frame16)
+{
+    if (frame16)
+    {
+        buf[i] = v;
+    }
+    else
+    {
+        ((uint8_t *)buf)[i] = (uint8_t)v;
+    }
+}
+
+uint16_t spi_bench_buf_get(const uint16_t *buf, uint32_t i, uint32_t frame16)
+{
+    return frame16 ? buf[i] : ((const uint8_t *)buf)[i];
+}
+
+uint32_t spi_bench_bit_errors(const uint16_t *a, const uint16_t *b, uint32_t n, uint32_t frame16)
+{
+    uint32_t errors = 0;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        errors += (uint32_t)__builtin_popcount(spi_bench_buf_get(a, i, frame16) ^
+                                               spi_bench_buf_get(b, i, frame16));
+    }
+    return errors;
+}
+
+/************************************************************/
+
+void spi_bench_rates(spi_bench_result_t *res, uint32_t n, uint32_t bits, uint32_t core_hz,
+                     uint32_t cycles, uint32_t ideal)
+{
+    if (cycles == 0U)
+    {
+        cycles = 1U;
+    }
+
+    res->kbytes_s = (uint32_t)(((uint64_t)n * (bits / 8U) * core_hz) / ((uint64_t)cycles * 1000U));
+    res->gap_cycles = (cycles > ideal) ? ((cycles - ideal) / n) : 0U;
+}
+
+/*
+    Columns line up with the header, values are printed as unsigned long
+    so the same format string is right for the target and a 64-bit host.
+*/
+int spi_bench_fmt_title(char *buf, size_t len, uint32_t sysclk, uint32_t frames)
+{
+    return snprintf(buf, len, "SPI1 -> SPI2 loopback, SYSCLK %lu Hz, %lu frames",
+                    (unsigned long)sysclk, (unsigned long)frames);
+}
+
+int spi_bench_fmt_header(char *buf, size_t len)
+{
+    return snprintf(buf, len, "MODE BITS CPOL/CPHA BR   SCK(kHz)  kB/s  GAP(cyc) LAT_MIN LAT_MAX BIT_ERR");
+}
+
+int spi_bench_fmt_row(char *buf, size_t len, spi_bench_mode_t mode, uint32_t frame16,
+                      uint32_t cp, uint32_t br, const spi_bench_result_t *res)
+{
+    return snprintf(buf, len, "%-4s %4u     %lu/%lu    %lu %10lu %6lu %8lu %7lu %7lu %7lu%s",
+                    mode_name[mode], frame16 ? 16U : 8U,
+                    (unsigned long)((cp >> 1) & 1U), (unsigned long)(cp & 1U), (unsigned long)br,
+                    (unsigned long)(res->sck_hz / 1000U), (unsigned long)res->kbytes_s,
+                    (unsigned long)res->gap_cycles, (unsigned long)res->lat_min,
+                    (unsigned long)res->lat_max, (unsigned long)res->bit_errors,
+                    res->timeout ? "  TIMEOUT" : "");
+}
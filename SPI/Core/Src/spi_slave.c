@@ -0,0 +1,217 @@
+
+#include "spi.h"
+#include "spi_slave.h"
+#include "regclr.h"
+
+/*
+    SPI2 register-map server
+
+    PB12 -> SPI2_NSS  (hardware NSS, also EXTI12 for end of frame)
+    PB13 -> SPI2_SCK
+    PB14 -> SPI2_MISO
+    PB15 -> SPI2_MOSI
+
+    DMA1 Stream3 Channel0 -> SPI2_RX
+    DMA1 Stream4 Channel0 -> SPI2_TX
+
+    CPU work per transaction:
+    1. RXNE interrupt on the command byte -> point the DMA streams at spi2_regs[addr]
+    2. NSS rising edge (EXTI12)           -> stop DMA, report the write, re-arm for next command
+    All data bytes in between are moved by circular DMA only.
+*/
+
+#define SPI2_IDLE_BYTE      0xFFU          // Shifted out while the command byte comes in
+
+volatile uint8_t spi2_regs[SPI2_REGMAP_SIZE];
+
+static spi2_regmap_cb_t regmap_cb;
+static volatile uint8_t cur_cmd;
+static volatile uint8_t rx_sink;               // Received bytes of a READ are dropped here
+
+/************************************************************/
+
+static void spi2_dma_stop(void)
+{
+    // Disable both streams and wait until the hardware really stopped them
+    DMA1_Stream3->CR &= ~(DMA_SxCR_EN);
+    DMA1_Stream4->CR &= ~(DMA_SxCR_EN);
+    while ((DMA1_Stream3->CR & DMA_SxCR_EN) || (DMA1_Stream4->CR & DMA_SxCR_EN)){}
+
+    // Clear every flag of stream 3 and stream 4 (write 1 to clear)
+    dma_stream_clear(DMA1, 3);
+    dma_stream_clear(DMA1, 4);
+}
+
+static void spi2_slave_arm(void)
+{
+    /*
+        Reset SPI2 instead of disabling SPE:
+        it is the only way to drop a byte that DMA already loaded into the TX buffer
+    */
+    RCC->APB1RSTR |= RCC_APB1RSTR_SPI2RST;
+    RCC->APB1RSTR &= ~(RCC_APB1RSTR_SPI2RST);
+
+    // CPOL = 1, CPHA = 1, MSB first, 8-bit, slave, hardware NSS (SSM = 0)
+    SPI2->CR1 = (SPI_CR1_CPOL | SPI_CR1_CPHA);
+
+    SPI2->CR2 = SPI_CR2_RXNEIE;            // Interrupt only for the command byte
+
+    SPI2->CR1 |= SPI_CR1_SPE;
+
+    SPI2->DR = SPI2_IDLE_BYTE;             // Byte returned while the command is received
+}
+
+/************************************************************/
+
+static void spi2_nss_gpio_config(void)
+{
+    // Enable clock for GPIOB and SYSCFG
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOBEN;
+    RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+    (void)RCC->APB2ENR;
+
+    // PB12 -> AF5 (SPI2_NSS)
+    GPIOB->MODER &= ~(3U << 24);
+    GPIOB->MODER |=  (2U << 24);
+
+    GPIOB->AFR[1] &= ~(15U << 16);
+    GPIOB->AFR[1] |=  (5U << 16);
+
+    // Pull-up so a floating NSS never selects the slave
+    GPIOB->PUPDR &= ~(3U << 24);
+    GPIOB->PUPDR |=  (1U << 24);
+
+    /*
+        EXTI12 on port B, rising edge = end of frame.
+        The input path stays active in AF mode, so EXTI sees the NSS pin too.
+    */
+    SYSCFG->EXTICR[3] &= ~(15U << 0);
+    SYSCFG->EXTICR[3] |=  (1U << 0);
+
+    EXTI->RTSR |= (1U << 12);
+    EXTI->IMR  |= (1U << 12);
+    exti_pr_clear(1U << 12);           // Clear only line 12
+}
+
+static void spi2_dma_config(void)
+{
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+    (void)RCC->AHB1ENR;
+
+    spi2_dma_stop();
+
+    // Stream3 : SPI2_RX, peripheral -> memory, circular, 8-bit
+    DMA1_Stream3->PAR = (uint32_t)&SPI2->DR;
+    DMA1_Stream3->CR  = (0U << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 | DMA_SxCR_CIRC;
+
+    // Stream4 : SPI2_TX, memory -> peripheral, circular, 8-bit
+    DMA1_Stream4->PAR = (uint32_t)&SPI2->DR;
+    DMA1_Stream4->CR  = (0U << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 | DMA_SxCR_CIRC | DMA_SxCR_DIR_0 | DMA_SxCR_MINC;
+}
+
+/************************************************************/
+
+void spi2_regmap_init(void)
+{
+    spi2_gpio_config();        // SCK, MISO, MOSI
+    spi2_nss_gpio_config();    // NSS + end of frame interrupt
+
+    RCC->APB1ENR |= RCC_APB1ENR_SPI2EN;
+    (void)RCC->APB1ENR;
+
+    spi2_dma_config();
+    spi2_slave_arm();
+
+    // NSS edge must not be delayed by the command ISR
+    NVIC_SetPriority(EXTI15_10_IRQn, 1);
+    NVIC_SetPriority(SPI2_IRQn, 2);
+    NVIC_EnableIRQ(EXTI15_10_IRQn);
+    NVIC_EnableIRQ(SPI2_IRQn);
+}
+
+void spi2_regmap_set_callback(spi2_regmap_cb_t cb)
+{
+    regmap_cb = cb;
+}
+
+/************************************************************/
+
+/*
+    Command byte received.
+    From here on the data phase is handled by DMA only.
+*/
+void SPI2_IRQHandler(void)
+{
+    uint8_t cmd = SPI2->DR;
+    uint8_t addr = cmd & (SPI2_REGMAP_SIZE - 1U);
+
+    SPI2->CR2 &= ~(SPI_CR2_RXNEIE);
+    cur_cmd = cmd;
+
+    if (cmd & SPI2_REGMAP_READ)
+    {
+        // RX: drop everything into one byte
+        DMA1_Stream3->CR  &= ~(DMA_SxCR_MINC);
+        DMA1_Stream3->M0AR = (uint32_t)&rx_sink;
+        DMA1_Stream3->NDTR = 1U;
+
+        // TX: register file from addr, wraps to addr
+        DMA1_Stream4->M0AR = (uint32_t)&spi2_regs[addr];
+        DMA1_Stream4->NDTR = SPI2_REGMAP_SIZE - addr;
+
+        /*
+            The TX buffer is already empty here (the idle byte went to the shifter
+            with the command byte): fill it with the turnaround byte, so the first
+            DMA request comes with the turnaround byte and data0 follows it
+        */
+        SPI2->DR = SPI2_IDLE_BYTE;
+
+        DMA1_Stream3->CR |= DMA_SxCR_EN;
+        DMA1_Stream4->CR |= DMA_SxCR_EN;
+        SPI2->CR2 |= (SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+    }
+    else
+    {
+        // RX: straight into the register file from addr
+        DMA1_Stream3->CR  |= DMA_SxCR_MINC;
+        DMA1_Stream3->M0AR = (uint32_t)&spi2_regs[addr];
+        DMA1_Stream3->NDTR = SPI2_REGMAP_SIZE - addr;
+
+        DMA1_Stream3->CR |= DMA_SxCR_EN;
+        SPI2->CR2 |= SPI_CR2_RXDMAEN;
+    }
+}
+
+/*
+    NSS rising edge -> end of transaction
+*/
+void EXTI15_10_IRQHandler(void)
+{
+    if (!(EXTI->PR & (1U << 12)))
+    {
+        return;
+    }
+    exti_pr_clear(1U << 12);           // Write 1 clears only line 12
+
+    uint8_t cmd = cur_cmd;
+    uint32_t left = DMA1_Stream3->NDTR;
+    uint32_t wrapped = DMA1->LISR & DMA_LISR_TCIF3;    // Circular RX reloaded NDTR at least once
+    uint32_t rx_enabled = SPI2->CR2 & SPI_CR2_RXDMAEN;
+
+    spi2_dma_stop();
+    spi2_slave_arm();
+
+    // Report writes that moved at least one data byte
+    if (rx_enabled && !(cmd & SPI2_REGMAP_READ) && (regmap_cb != 0))
+    {
+        uint8_t addr = cmd & (SPI2_REGMAP_SIZE - 1U);
+        // After a wrap every register from addr to the end was written
+        uint32_t len = wrapped ? (SPI2_REGMAP_SIZE - addr) : ((SPI2_REGMAP_SIZE - addr) - left);
+
+        if (len != 0U)
+        {
+            regmap_cb(addr, (uint8_t)len);
+        }
+    }
+    cur_cmd = 0;
+}
@@ -0,0 +1,64 @@
+
+#include "uart.h"
+
+/*
+    PA2 -> USART2_TX (AF7)
+    Connected to the ST-LINK virtual COM port on the Nucleo board
+*/
+
+static uint32_t Baudrate_config(uint32_t Clk_freq, uint32_t Baudrate)
+{
+    return ((Clk_freq + (Baudrate/2)) / Baudrate);
+}
+
+void uart2_config(void)
+{
+    // Enable clock for GPIOA (USART2 TX pin)
+    RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;
+    (void)RCC->AHB1ENR;
+
+    // Configure PA2 as Alternate Function
+    GPIOA->MODER &= ~(3U << 4);
+    GPIOA->MODER |=  (2U << 4);
+
+    // AF7 = USART2_TX
+    GPIOA->AFR[0] &= ~(0xFU << 8);
+    GPIOA->AFR[0] |=  (7U << 8);
+
+    // Enable clock for USART2
+    RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
+    (void)RCC->APB1ENR;
+
+    // Disable USART before configuration
+    USART2->CR1 &= ~USART_CR1_UE;
+
+    // USART2 is on APB1, use the real PCLK1
+    SystemCoreClockUpdate();
+    uint32_t pclk1 = SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+    USART2->BRR = Baudrate_config(pclk1, BAUDRATE);
+
+    USART2->CR1 |= USART_CR1_TE;
+    USART2->CR1 |= USART_CR1_UE;
+}
+
+void uart2_tx(char ch)
+{
+    // Wait until transmit data register is empty
+    while(!(USART2->SR & USART_SR_TXE)) {}
+
+    USART2->DR = ch;
+}
+
+/*
+    Retarget printf() to USART2
+    _write() in syscalls.c calls __io_putchar() for every character
+*/
+int __io_putchar(int ch)
+{
+    if (ch == '\n')
+    {
+        uart2_tx('\r');
+    }
+    uart2_tx(ch);
+    return ch;
+}
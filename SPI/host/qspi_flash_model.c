@@ -0,0 +1,281 @@
+#include <string.h>
+#include "qspi_cmd.h"
+#include "qspi_flash_model.h"
+
+/*
+    qspi_cmd.h on a W25Q style flash model (see qspi_flash_model.h).
+    Same command codes as qspi.c, an unexpected one is rejected.
+*/
+
+#define CMD_WRITE_ENABLE      0x06U
+#define CMD_READ_SR1          0x05U
+#define CMD_READ_SR2          0x35U
+#define CMD_WRITE_SR2         0x31U
+#define CMD_QUAD_READ         0xEBU
+#define CMD_QUAD_PROGRAM      0x32U
+#define CMD_SECTOR_ERASE      0x20U
+#define CMD_CHIP_ERASE        0xC7U
+
+#define READ_MODE_NONE        0xFFU     // Mode byte without continuous read
+#define POLL_LIMIT            1000000U
+
+flash_model_t flash;
+
+/************************************************************/
+
+void flash_model_reset(void)
+{
+    memset(&flash, 0, sizeof(flash));
+    memset(flash.mem, 0xFF, sizeof(flash.mem));
+}
+
+// A new command: only SR1 reads get through while busy or mapped
+static int accept(void)
+{
+    if ((flash.busy != 0U) || flash.mapped)
+    {
+        flash.rejected++;
+        return 0;
+    }
+    return 1;
+}
+
+// Program / erase / write SR need a preceding write enable, which they use up
+static int write_enabled(uint32_t busy)
+{
+    if (!(flash.sr1 & FLASH_SR1_WEL))
+    {
+        flash.rejected++;
+        return 0;
+    }
+    flash.sr1 &= ~FLASH_SR1_WEL;
+    flash.busy = busy;
+    return 1;
+}
+
+/************************************************************/
+
+void qspi_cmd_gpio_config(void)
+{
+}
+
+void qspi_cmd_init(void)
+{
+    flash.mapped = 0;
+}
+
+void qspi_cmd(uint8_t cmd)
+{
+    if (!accept())
+    {
+        return;
+    }
+
+    if (cmd == CMD_WRITE_ENABLE)
+    {
+        flash.sr1 |= FLASH_SR1_WEL;
+    }
+    else if (cmd == CMD_CHIP_ERASE)
+    {
+        if (write_enabled(FLASH_BUSY_CHIP))
+        {
+            memset(flash.mem, 0xFF, sizeof(flash.mem));
+            flash.erases++;
+        }
+    }
+    else
+    {
+        flash.rejected++;
+    }
+}
+
+void qspi_cmd_addr(uint8_t cmd, uint32_t addr)
+{
+    if (!accept())
+    {
+        return;
+    }
+
+    if ((cmd == CMD_SECTOR_ERASE) && write_enabled(FLASH_BUSY_SECTOR))
+    {
+        // The chip ignores the low address bits
+        addr &= (QSPI_FLASH_SIZE - 1U) & ~(QSPI_SECTOR_SIZE - 1U);
+        memset(&flash.mem[addr], 0xFF, QSPI_SECTOR_SIZE);
+        flash.erases++;
+    }
+    else if (cmd != CMD_SECTOR_ERASE)
+    {
+        flash.rejected++;
+    }
+}
+
+uint8_t qspi_cmd_read_reg(uint8_t cmd)
+{
+    if (cmd == CMD_READ_SR1)
+    {
+        flash.polls++;
+        if (flash.busy != 0U)
+        {
+            flash.busy--;
+            return flash.sr1 | FLASH_SR1_WIP;
+        }
+        return flash.sr1;
+    }
+
+    if (!accept())
+    {
+        return 0xFFU;
+    }
+    if (cmd == CMD_READ_SR2)
+    {
+        return flash.sr2;
+    }
+
+    flash.rejected++;
+    return 0xFFU;
+}
+
+void qspi_cmd_write_reg(uint8_t cmd, uint8_t val)
+{
+    if (!accept())
+    {
+        return;
+    }
+
+    if ((cmd == CMD_WRITE_SR2) && write_enabled(FLASH_BUSY_WRITE_SR))
+    {
+        flash.sr2 = val & FLASH_SR2_QE;
+    }
+    else if (cmd != CMD_WRITE_SR2)
+    {
+        flash.rejected++;
+    }
+}
+
+void qspi_cmd_poll(uint8_t cmd, uint8_t mask, uint8_t match)
+{
+    for (uint32_t i = 0; i < POLL_LIMIT; i++)
+    {
+        if ((qspi_cmd_read_reg(cmd) & mask) == match)
+        {
+            return;
+        }
+    }
+    flash.rejected++;                      // The hardware would poll forever
+}
+
+/************************************************************/
+
+static void quad_read(uint8_t cmd, uint8_t mode, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    // Bus not driven: the buffer reads as all ones
+    if (!accept())
+    {
+        memset(buf, 0xFF, len);
+        return;
+    }
+    if ((cmd != CMD_QUAD_READ) || (mode != READ_MODE_NONE) || !(flash.sr2 & FLASH_SR2_QE))
+    {
+        flash.rejected++;
+        memset(buf, 0xFF, len);
+        return;
+    }
+
+    // Reads run on across the whole chip and wrap at the end
+    for (uint32_t i = 0; i < len; i++)
+    {
+        buf[i] = flash.mem[(addr + i) & (QSPI_FLASH_SIZE - 1U)];
+    }
+}
+
+void qspi_cmd_read_quad(uint8_t cmd, uint8_t mode, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (len == 0U)
+    {
+        return;
+    }
+    flash.reads++;
+    quad_read(cmd, mode, addr, buf, len);
+}
+
+void qspi_cmd_read_quad_dma(uint8_t cmd, uint8_t mode, uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    if (len == 0U)
+    {
+        return;
+    }
+    flash.dma_reads++;
+    quad_read(cmd, mode, addr, buf, len);
+}
+
+void qspi_cmd_write_quad(uint8_t cmd, uint32_t addr, const uint8_t *buf, uint32_t len)
+{
+    uint8_t latch[QSPI_PAGE_SIZE];
+    uint32_t page;
+
+    if ((len == 0U) || !accept())
+    {
+        return;
+    }
+    if ((cmd != CMD_QUAD_PROGRAM) || !(flash.sr2 & FLASH_SR2_QE))
+    {
+        flash.rejected++;
+        return;
+    }
+    if (!write_enabled(FLASH_BUSY_PROGRAM))
+    {
+        return;
+    }
+
+    // The page latch takes the data, the address wraps inside the page
+    addr &= QSPI_FLASH_SIZE - 1U;
+    page = addr & ~(QSPI_PAGE_SIZE - 1U);
+    memset(latch, 0xFF, sizeof(latch));
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        latch[(addr + i) % QSPI_PAGE_SIZE] = buf[i];
+    }
+
+    // Programming can only clear bits
+    for (uint32_t i = 0; i < QSPI_PAGE_SIZE; i++)
+    {
+        flash.mem[page + i] &= latch[i];
+    }
+
+    flash.programs++;
+    if (len > flash.max_burst)
+    {
+        flash.max_burst = len;
+    }
+}
+
+/************************************************************/
+
+void qspi_cmd_mapped(uint8_t cmd, uint8_t mode)
+{
+    if (!accept())
+    {
+        return;
+    }
+    if ((cmd != CMD_QUAD_READ) || (mode != READ_MODE_NONE) || !(flash.sr2 & FLASH_SR2_QE))
+    {
+        flash.rejected++;
+        return;
+    }
+    flash.mapped = 1;
+}
+
+void qspi_cmd_abort(void)
+{
+    flash.mapped = 0;
+}
+
+const uint8_t *qspi_cmd_window(void)
+{
+    if (!flash.mapped)
+    {
+        flash.rejected++;
+    }
+    return flash.mem;
+}
@@ -0,0 +1,53 @@
+// Header file for the host model of a W25Q style quad NOR flash
+// Implements qspi_cmd.h, so qspi.c runs unchanged on top of it.
+
+#ifndef HOST_QSPI_FLASH_MODEL_H_
+#define HOST_QSPI_FLASH_MODEL_H_
+
+#include <stdint.h>
+#include "qspi.h"
+
+/*
+    Commands: 0x06 write enable, 0x05 / 0x35 read SR1 / SR2, 0x31 write SR2,
+    0xEB quad read (1-4-4, mode byte 0xFF), 0x32 quad page program (1-1-4),
+    0x20 sector erase, 0xC7 chip erase.
+
+    Time only passes on SR1 reads: after a program / erase, WIP stays set
+    for the number of SR1 reads below. Every other command while WIP is set
+    is ignored, as on the chip, and counted in 'rejected'.
+
+    A page program latches at most one page: data past the end of the page
+    wraps to its start. Programming only clears bits, erase sets them to 1.
+*/
+#define FLASH_BUSY_PROGRAM    4U
+#define FLASH_BUSY_SECTOR     32U
+#define FLASH_BUSY_CHIP       256U
+#define FLASH_BUSY_WRITE_SR   8U
+
+#define FLASH_SR1_WIP         (1U << 0)
+#define FLASH_SR1_WEL         (1U << 1)
+#define FLASH_SR2_QE          (1U << 1)
+
+typedef struct
+{
+    uint8_t  mem[QSPI_FLASH_SIZE];
+    uint8_t  sr1;                 // WEL (WIP comes from 'busy')
+    uint8_t  sr2;                 // QE
+    uint32_t busy;                // SR1 reads left with WIP set
+    uint8_t  mapped;              // 1 = memory-mapped mode
+
+    // Counters for the checks
+    uint32_t reads;               // Indirect 0xEB reads by the CPU
+    uint32_t dma_reads;           // Indirect 0xEB reads by DMA
+    uint32_t programs;            // Accepted 0x32 commands
+    uint32_t erases;              // Accepted 0x20 / 0xC7 commands
+    uint32_t polls;               // SR1 reads
+    uint32_t max_burst;           // Longest 0x32 data phase
+    uint32_t rejected;            // Busy, no WEL, no QE, mapped, unknown command
+} flash_model_t;
+
+extern flash_model_t flash;
+
+void flash_model_reset(void);     // Erased chip, QE off, idle, counters cleared
+
+#endif /* HOST_QSPI_FLASH_MODEL_H_ */
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <string.h>
+#include "qspi.h"
+#include "qspi_cmd.h"
+#include "qspi_flash_model.h"
+
+/*
+    Host check of qspi.c on the flash model (qspi_flash_model.c)
+    - qspi_config() sets QE once
+    - The QSPI_DEMO case (main.c): 300 bytes from the start of the last
+      sector cross a page boundary, all four read paths return them
+    - An unaligned program that spans three pages
+    - The model itself wraps a raw page program inside the page
+    - Sector erase back to 0xFF, program only clears bits
+    - WIP polling: no command reaches the flash while it is busy
+    - Read-ahead cache hit / miss / invalidate, also after a program
+    Returns 0 when everything matches, prints the failing checks otherwise.
+*/
+
+#define DEMO_ADDR   (QSPI_FLASH_SIZE - QSPI_SECTOR_SIZE)
+#define DEMO_LEN    300U
+
+static unsigned failures;
+static uint8_t tx[QSPI_SECTOR_SIZE], rx[QSPI_SECTOR_SIZE];
+
+static void check(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static int all_ff(const uint8_t *p, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (p[i] != 0xFFU)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/************************************************************/
+
+static void check_config(void)
+{
+    flash_model_reset();
+    qspi_gpio_config();
+    qspi_config();
+
+    check((flash.sr2 & FLASH_SR2_QE) != 0U, "config sets QE");
+    check(flash.polls == (FLASH_BUSY_WRITE_SR + 1U), "config waits for the SR2 write");
+
+    // Second config finds QE already set and writes nothing
+    flash.polls = 0;
+    qspi_config();
+    check(flash.polls == 0U, "QE is written only once");
+    check(flash.rejected == 0U, "config: nothing rejected");
+}
+
+static void check_demo(void)
+{
+    uint32_t programs = flash.programs;
+
+    // Same pattern as qspi_demo()
+    for (uint32_t i = 0; i < DEMO_LEN; i++)
+    {
+        tx[i] = (uint8_t)((i * 7U) ^ (i >> 8));
+    }
+
+    memset(&flash.mem[DEMO_ADDR], 0x00, QSPI_SECTOR_SIZE);     // Old content
+    qspi_erase_sector(DEMO_ADDR + 123U);                       // Any address in the sector
+    check(all_ff(&flash.mem[DEMO_ADDR], QSPI_SECTOR_SIZE), "sector erased to 0xFF");
+
+    qspi_program(DEMO_ADDR, tx, DEMO_LEN);
+    check((flash.programs - programs) == 2U, "demo: 256 + 44 byte page programs");
+    check(flash.max_burst <= QSPI_PAGE_SIZE, "demo: no program crosses a page");
+    check(all_ff(&flash.mem[DEMO_ADDR + DEMO_LEN], QSPI_SECTOR_SIZE - DEMO_LEN), "demo: rest of the sector untouched");
+
+    qspi_read(DEMO_ADDR, rx, DEMO_LEN);
+    check(memcmp(rx, tx, DEMO_LEN) == 0, "demo: indirect read");
+
+    memset(rx, 0, DEMO_LEN);
+    qspi_read_dma(DEMO_ADDR, rx, DEMO_LEN);
+    check(memcmp(rx, tx, DEMO_LEN) == 0, "demo: DMA read");
+
+    memset(rx, 0, DEMO_LEN);
+    qspi_read_cached(DEMO_ADDR, rx, DEMO_LEN);
+    check(memcmp(rx, tx, DEMO_LEN) == 0, "demo: cached read");
+
+    qspi_memory_mapped_enable();
+    memset(rx, 0, DEMO_LEN);
+    qspi_read_cached(DEMO_ADDR, rx, DEMO_LEN);                 // Through the mapped window
+    check(memcmp(rx, tx, DEMO_LEN) == 0, "demo: memory-mapped read");
+    qspi_memory_mapped_disable();
+
+    check(flash.rejected == 0U, "demo: nothing rejected");
+}
+
+static void check_unaligned(void)
+{
+    uint32_t addr = 0x1003F0U;                                 // 16 bytes before a page end
+    uint32_t programs = flash.programs;
+
+    for (uint32_t i = 0; i < DEMO_LEN; i++)
+    {
+        tx[i] = (uint8_t)(0xA5U ^ i);
+    }
+
+    qspi_erase_sector(addr);
+    qspi_program(addr, tx, DEMO_LEN);
+
+    check((flash.programs - programs) == 3U, "unaligned: 16 + 256 + 28 byte page programs");
+    check(memcmp(&flash.mem[addr], tx, DEMO_LEN) == 0, "unaligned: data in place");
+    check(all_ff(&flash.mem[0x100000U], 0x3F0U), "unaligned: bytes before untouched");
+    check(flash.rejected == 0U, "unaligned: nothing rejected");
+}
+
+/*
+    What qspi_program() avoids: one raw 0x32 across the page end
+    lands the tail at the START of the same page
+*/
+static void check_model_wrap(void)
+{
+    uint32_t page = 0x200000U;
+
+    for (uint32_t i = 0; i < 32U; i++)
+    {
+        tx[i] = (uint8_t)i;
+    }
+
+    qspi_erase_sector(page);
+    qspi_cmd(0x06U);
+    qspi_cmd_write_quad(0x32U, page + 0xF0U, tx, 32U);
+    qspi_cmd_poll(0x05U, FLASH_SR1_WIP, 0U);
+
+    check(memcmp(&flash.mem[page + 0xF0U], &tx[0], 16U) == 0, "wrap: head at the page end");
+    check(memcmp(&flash.mem[page], &tx[16], 16U) == 0, "wrap: tail at the page start");
+    check(all_ff(&flash.mem[page + QSPI_PAGE_SIZE], QSPI_PAGE_SIZE), "wrap: next page untouched");
+
+    // Program only clears bits: 0xF0 over 0x0F is 0x00 without an erase
+    tx[0] = 0x0FU;
+    tx[1] = 0xF0U;
+    qspi_program(page + 0x80U, tx, 1U);
+    qspi_program(page + 0x80U, &tx[1], 1U);
+    check(flash.mem[page + 0x80U] == 0x00U, "program only clears bits");
+
+    qspi_erase_sector(page);
+    check(all_ff(&flash.mem[page], QSPI_SECTOR_SIZE), "erase sets every bit again");
+}
+
+static void check_wip(void)
+{
+    uint32_t polls;
+    uint32_t rejected = flash.rejected;
+
+    // The driver polls until WIP clears: busy reads + the one that sees it clear
+    polls = flash.polls;
+    qspi_erase_sector(0);
+    check((flash.polls - polls) == (FLASH_BUSY_SECTOR + 1U), "erase polls WIP to the end");
+
+    polls = flash.polls;
+    qspi_program(0, tx, 1U);
+    check((flash.polls - polls) == (FLASH_BUSY_PROGRAM + 1U), "program polls WIP to the end");
+
+    check(flash.rejected == rejected, "no command while WIP");
+
+    // Without the poll the flash ignores the next command
+    qspi_cmd(0x06U);
+    qspi_cmd_addr(0x20U, 0);
+    qspi_cmd_read_quad(0xEBU, 0xFFU, 0, rx, 4U);
+    check(flash.rejected == (rejected + 1U), "read while WIP is rejected");
+    check(all_ff(rx, 4U), "read while WIP returns 0xFF");
+    qspi_cmd_poll(0x05U, FLASH_SR1_WIP, 0U);
+
+    // Chip erase, the longest wait
+    polls = flash.polls;
+    qspi_erase_chip();
+    check((flash.polls - polls) == (FLASH_BUSY_CHIP + 1U), "chip erase polls WIP to the end");
+    check(all_ff(flash.mem, QSPI_FLASH_SIZE), "chip erased to 0xFF");
+}
+
+static void check_cache(void)
+{
+    uint32_t line = 0x300000U;
+    uint32_t reads;
+    uint32_t rejected = flash.rejected;
+    uint8_t b[2] = { 0x12U, 0x34U };
+
+    for (uint32_t i = 0; i < (2U * QSPI_CACHE_LINE); i++)
+    {
+        tx[i] = (uint8_t)(i + 1U);
+    }
+    qspi_program(line, tx, 2U * QSPI_CACHE_LINE);
+    qspi_cache_invalidate();
+
+    reads = flash.dma_reads;
+    qspi_read_cached(line + 8U, rx, 16U);
+    check((flash.dma_reads - reads) == 1U, "cache: first read misses");
+    qspi_read_cached(line + 24U, rx + 16U, 16U);
+    check((flash.dma_reads - reads) == 1U, "cache: same line hits");
+    check(memcmp(rx, &tx[8], 32U) == 0, "cache: data");
+
+    // Across the line end: the second line is fetched
+    qspi_read_cached(line + QSPI_CACHE_LINE - 4U, rx, 8U);
+    check((flash.dma_reads - reads) == 2U, "cache: next line misses");
+    check(memcmp(rx, &tx[QSPI_CACHE_LINE - 4U], 8U) == 0, "cache: data across lines");
+
+    qspi_cache_invalidate();
+    qspi_read_cached(line + QSPI_CACHE_LINE, rx, 4U);
+    check((flash.dma_reads - reads) == 3U, "cache: miss after invalidate");
+
+    // A program into the cached line must not leave stale data
+    qspi_program(line + QSPI_CACHE_LINE + 1U, b, 2U);
+    qspi_read_cached(line + QSPI_CACHE_LINE, rx, 4U);
+    check((flash.dma_reads - reads) == 4U, "cache: miss after program");
+    check((rx[1] == (tx[QSPI_CACHE_LINE + 1U] & 0x12U)) && (rx[2] == (tx[QSPI_CACHE_LINE + 2U] & 0x34U)),
+          "cache: new data after program");
+
+    check(flash.rejected == rejected, "cache: nothing rejected");
+}
+
+int main(void)
+{
+    check_config();
+    check_demo();
+    check_unaligned();
+    check_model_wrap();
+    check_wip();
+    check_cache();
+
+    printf("programs %u, erases %u, SR1 polls %u, rejected %u\n",
+           (unsigned)flash.programs, (unsigned)flash.erases, (unsigned)flash.polls, (unsigned)flash.rejected);
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
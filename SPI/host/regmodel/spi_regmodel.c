@@ -0,0 +1,421 @@
+#include <string.h>
+#include "stm32f4xx.h"
+#include "spi.h"
+#include "uart.h"
+#include "spi_regmodel.h"
+
+/*
+    SPI1 -> SPI2 loopback and DMA model behind the host stm32f4xx.h
+    (behaviour in spi_regmodel.h)
+*/
+
+void SPI1_IRQHandler(void);                    // spi_bench.c
+
+SPI_TypeDef host_spi[2];
+DMA_TypeDef host_dma[2];
+DMA_Stream_TypeDef host_dma_stream[2][8];
+RCC_TypeDef host_rcc;
+DWT_Type host_dwt;
+CoreDebug_Type host_coredebug;
+EXTI_TypeDef host_exti;
+uint32_t SystemCoreClock;
+
+host_spi_stats_t host_spi_stats;
+uint16_t host_spi_flip;
+
+typedef struct
+{
+    uint16_t txbuf;
+    uint8_t  txfull;           // TXE = 0
+    uint16_t rxbuf;
+    uint8_t  rxne;
+    uint16_t shift;            // Word on the wire
+    uint8_t  ovr;
+    uint8_t  udr;
+} spi_state_t;
+
+// Stream -> SPI request mapping of the F446 (RM0390 DMA request tables)
+typedef struct
+{
+    uint8_t dma;               // 0 = DMA1, 1 = DMA2
+    uint8_t stream;
+    uint8_t channel;
+    uint8_t spi;               // 0 = SPI1, 1 = SPI2
+    uint8_t to_periph;
+} dma_req_t;
+
+static const dma_req_t dma_req[] =
+{
+    { 1, 2, 3, 0, 0 },         // SPI1_RX
+    { 1, 3, 3, 0, 1 },         // SPI1_TX
+    { 0, 3, 0, 1, 0 },         // SPI2_RX
+    { 0, 4, 0, 1, 1 },         // SPI2_TX
+};
+
+static spi_state_t spi_st[2];
+static uint64_t now;                           // Core cycles since reset
+static uint64_t frame_end;
+static uint8_t on_wire;                        // Master frame being shifted
+static uint8_t irq_on[2];
+static uint8_t in_irq;
+static uint32_t cyc_base;                      // CYCCNT = now - cyc_base
+static uint32_t cyc_shadow;                    // Last CYCCNT value the model wrote
+static uint32_t dma_len[2][8];                 // NDTR when the stream was enabled
+static uint8_t dma_on[2][8];
+
+/************************************************************/
+
+static const uint32_t spi_clk_en[2]  = { RCC_APB2ENR_SPI1EN, RCC_APB1ENR_SPI2EN };
+static const uint32_t dma_clk_en[2]  = { RCC_AHB1ENR_DMA1EN, RCC_AHB1ENR_DMA2EN };
+
+static int spi_clocked(uint32_t i)
+{
+    return ((i == 0U) ? host_rcc.APB2ENR : host_rcc.APB1ENR) & spi_clk_en[i];
+}
+
+static void spi_reset(uint32_t i)
+{
+    memset((void *)&host_spi[i], 0, sizeof(host_spi[i]));
+    memset(&spi_st[i], 0, sizeof(spi_st[i]));
+    host_spi[i].SR = SPI_SR_TXE;
+    if (i == 0U)
+    {
+        on_wire = 0;
+    }
+}
+
+// Master: SPE, MSTR and NSS high (SSM + SSI); slave: SPE, no MSTR, NSS low (SSM, SSI = 0)
+static int master_ready(void)
+{
+    uint32_t cr1 = host_spi[0].CR1;
+
+    return spi_clocked(0) && (cr1 & SPI_CR1_SPE) && (cr1 & SPI_CR1_MSTR) &&
+           (!(cr1 & SPI_CR1_SSM) || (cr1 & SPI_CR1_SSI));
+}
+
+static int slave_selected(void)
+{
+    uint32_t cr1 = host_spi[1].CR1;
+
+    return spi_clocked(1) && (cr1 & SPI_CR1_SPE) && !(cr1 & SPI_CR1_MSTR) &&
+           (!(cr1 & SPI_CR1_SSM) || !(cr1 & SPI_CR1_SSI));
+}
+
+static void spi_deliver(uint32_t i, uint16_t v)
+{
+    if (spi_st[i].rxne)
+    {
+        spi_st[i].ovr = 1;                     // Old data stays, the new frame is lost
+        host_spi_stats.ovr++;
+        return;
+    }
+    spi_st[i].rxbuf = v;
+    spi_st[i].rxne = 1;
+}
+
+static void spi_step(void)
+{
+    spi_state_t *m = &spi_st[0];
+    spi_state_t *s = &spi_st[1];
+
+    if (on_wire && (now >= frame_end))
+    {
+        uint32_t mode = SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_DFF;
+        uint16_t mask = (host_spi[0].CR1 & SPI_CR1_DFF) ? 0xFFFFU : 0x00FFU;
+        uint16_t to_slave = m->shift;
+        uint16_t to_master = s->shift ^ host_spi_flip;
+
+        if ((host_spi[0].CR1 ^ host_spi[1].CR1) & mode)
+        {
+            to_slave = (uint16_t)~to_slave;
+            to_master = (uint16_t)~to_master;
+        }
+
+        if (slave_selected())
+        {
+            spi_deliver(1, to_slave & mask);
+        }
+        spi_deliver(0, to_master & mask);
+
+        host_spi_stats.frames++;
+        on_wire = 0;
+    }
+
+    if (!on_wire && m->txfull && master_ready())
+    {
+        uint32_t bits = (host_spi[0].CR1 & SPI_CR1_DFF) ? 16U : 8U;
+        uint32_t br = (host_spi[0].CR1 & SPI_CR1_BR) >> SPI_CR1_BR_Pos;
+
+        m->shift = m->txbuf;
+        m->txfull = 0;
+
+        // A selected slave without data still clocks out its shift register: 0 here
+        s->shift = 0xFFFFU;
+        if (slave_selected())
+        {
+            s->shift = 0;
+            if (s->txfull)
+            {
+                s->shift = s->txbuf;
+                s->txfull = 0;
+            }
+            else
+            {
+                s->udr = 1;
+                host_spi_stats.udr++;
+            }
+        }
+
+        frame_end = now + (bits * (2U << br));
+        on_wire = 1;
+    }
+}
+
+static void spi_update_sr(void)
+{
+    for (uint32_t i = 0; i < 2U; i++)
+    {
+        spi_state_t *st = &spi_st[i];
+        uint32_t busy = (i == 0U) ? (on_wire || st->txfull) : (on_wire && slave_selected());
+
+        host_spi[i].SR = (st->txfull ? 0U : SPI_SR_TXE) | (st->rxne ? SPI_SR_RXNE : 0U) |
+                         (st->ovr ? SPI_SR_OVR : 0U) | (st->udr ? SPI_SR_UDR : 0U) |
+                         (busy ? SPI_SR_BSY : 0U);
+    }
+}
+
+/************************************************************/
+
+static void dma_flag_tc(uint32_t dma, uint32_t stream)
+{
+    static const uint8_t pos[4] = { 0, 6, 16, 22 };
+    uint32_t bit = 0x20UL << pos[stream & 3U];
+
+    if (stream < 4U)
+    {
+        host_dma[dma].LISR |= bit;
+    }
+    else
+    {
+        host_dma[dma].HISR |= bit;
+    }
+}
+
+static void dma_step(void)
+{
+    for (uint32_t d = 0; d < 2U; d++)
+    {
+        // rc_w1 clear registers: apply and forget
+        host_dma[d].LISR &= ~host_dma[d].LIFCR;
+        host_dma[d].HISR &= ~host_dma[d].HIFCR;
+        host_dma[d].LIFCR = 0;
+        host_dma[d].HIFCR = 0;
+    }
+
+    for (uint32_t r = 0; r < (sizeof(dma_req) / sizeof(dma_req[0])); r++)
+    {
+        const dma_req_t *q = &dma_req[r];
+        DMA_Stream_TypeDef *s = &host_dma_stream[q->dma][q->stream];
+        spi_state_t *st = &spi_st[q->spi];
+        uint32_t cr = s->CR;
+        uint32_t size, addr;
+        uint8_t *mem;
+
+        if (!(cr & DMA_SxCR_EN) || !(host_rcc.AHB1ENR & dma_clk_en[q->dma]))
+        {
+            dma_on[q->dma][q->stream] = 0;
+            continue;
+        }
+        if (!dma_on[q->dma][q->stream])
+        {
+            dma_on[q->dma][q->stream] = 1;
+            dma_len[q->dma][q->stream] = s->NDTR;
+        }
+
+        // Wrong channel, peripheral address or direction: no request ever arrives
+        if ((((cr & DMA_SxCR_CHSEL) >> DMA_SxCR_CHSEL_Pos) != q->channel) ||
+            (s->PAR != (uint32_t)(uintptr_t)&host_spi[q->spi].DR) ||
+            (((cr & DMA_SxCR_DIR) == DMA_SxCR_DIR_0) != (q->to_periph != 0U)))
+        {
+            continue;
+        }
+
+        size = (cr & DMA_SxCR_MSIZE) ? 2U : 1U;
+        addr = s->M0AR + ((cr & DMA_SxCR_MINC) ? ((dma_len[q->dma][q->stream] - s->NDTR) * size) : 0U);
+        mem = (uint8_t *)(uintptr_t)addr;
+
+        if (s->NDTR != 0U)
+        {
+            if (q->to_periph && (host_spi[q->spi].CR2 & SPI_CR2_TXDMAEN) && !st->txfull)
+            {
+                st->txbuf = (size == 2U) ? *(uint16_t *)mem : *mem;
+                st->txfull = 1;
+                s->NDTR--;
+                host_spi_stats.dma_items++;
+            }
+            else if (!q->to_periph && (host_spi[q->spi].CR2 & SPI_CR2_RXDMAEN) && st->rxne)
+            {
+                if (size == 2U)
+                {
+                    *(uint16_t *)mem = st->rxbuf;
+                }
+                else
+                {
+                    *mem = (uint8_t)st->rxbuf;
+                }
+                st->rxne = 0;
+                s->NDTR--;
+                host_spi_stats.dma_items++;
+            }
+        }
+
+        if (s->NDTR == 0U)
+        {
+            dma_flag_tc(q->dma, q->stream);
+            s->CR &= ~DMA_SxCR_EN;
+            dma_on[q->dma][q->stream] = 0;
+        }
+    }
+}
+
+/************************************************************/
+
+static void dwt_step(void)
+{
+    // A CPU write to CYCCNT moves the base, a stopped counter keeps its value
+    if (host_dwt.CYCCNT != cyc_shadow)
+    {
+        cyc_base = (uint32_t)now - host_dwt.CYCCNT;
+    }
+    if (!(host_coredebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) || !(host_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk))
+    {
+        cyc_base = (uint32_t)now - host_dwt.CYCCNT;
+    }
+    host_dwt.CYCCNT = (uint32_t)now - cyc_base;
+    cyc_shadow = host_dwt.CYCCNT;
+}
+
+static void advance(uint32_t cycles)
+{
+    now += cycles;
+
+    if (host_rcc.APB2RSTR & RCC_APB2RSTR_SPI1RST)
+    {
+        spi_reset(0);
+    }
+    if (host_rcc.APB1RSTR & RCC_APB1RSTR_SPI2RST)
+    {
+        spi_reset(1);
+    }
+
+    spi_step();
+    dma_step();
+    spi_step();                                // A DMA refill starts the next frame at once
+    spi_update_sr();
+    dwt_step();
+}
+
+static int spi1_irq_pending(void)
+{
+    uint32_t cr2 = host_spi[0].CR2;
+
+    return irq_on[0] && spi_clocked(0) &&
+           (((cr2 & SPI_CR2_RXNEIE) && spi_st[0].rxne) || ((cr2 & SPI_CR2_TXEIE) && !spi_st[0].txfull));
+}
+
+void host_tick(void)
+{
+    advance(HOST_ACCESS_CYC);
+
+    // Taken between two accesses of thread code, never nested
+    if (!in_irq && spi1_irq_pending())
+    {
+        in_irq = 1;
+        host_spi_stats.irqs++;
+        advance(HOST_IRQ_CYC);
+        SPI1_IRQHandler();
+        in_irq = 0;
+    }
+}
+
+/************************************************************/
+
+uint16_t host_spi_dr_read(SPI_TypeDef *spi)
+{
+    spi_state_t *st = &spi_st[spi - host_spi];
+    uint16_t v = st->rxbuf;
+
+    st->rxne = 0;
+    spi_update_sr();
+    return v;
+}
+
+void host_spi_dr_write(SPI_TypeDef *spi, uint32_t v)
+{
+    spi_state_t *st = &spi_st[spi - host_spi];
+
+    st->txbuf = (uint16_t)v;                   // TXE = 0 overwrites, as on the chip
+    st->txfull = 1;
+    spi_update_sr();
+}
+
+void host_model_reset(void)
+{
+    memset(host_dma, 0, sizeof(host_dma));
+    memset(host_dma_stream, 0, sizeof(host_dma_stream));
+    memset((void *)&host_rcc, 0, sizeof(host_rcc));
+    memset((void *)&host_dwt, 0, sizeof(host_dwt));
+    memset((void *)&host_coredebug, 0, sizeof(host_coredebug));
+    memset(&host_spi_stats, 0, sizeof(host_spi_stats));
+    memset(dma_on, 0, sizeof(dma_on));
+    memset(irq_on, 0, sizeof(irq_on));
+    spi_reset(0);
+    spi_reset(1);
+
+    SystemCoreClock = 16000000U;
+    host_spi_flip = 0;
+    now = 0;
+    in_irq = 0;
+    cyc_base = 0;
+    cyc_shadow = 0;
+}
+
+uint64_t host_cycles(void)
+{
+    return now;
+}
+
+/************************************************************/
+/*
+    Board functions spi_bench.c calls: no pins and no UART on the host,
+    printf() goes to stdout.
+*/
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t prio)
+{
+    (void)irq;
+    (void)prio;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    irq_on[irq == SPI2_IRQn] = 1;
+}
+
+uint32_t spi_pclk_freq(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+    return SystemCoreClock;
+}
+
+void spi1_gpio_config(void)
+{
+}
+
+void spi2_gpio_config(void)
+{
+}
+
+void uart2_config(void)
+{
+}
@@ -0,0 +1,43 @@
+// Header file for the host SPI1 -> SPI2 loopback register model
+// Runs spi_bench.c unchanged on a PC (see stm32f4xx.h in this directory).
+
+#ifndef HOST_SPI_REGMODEL_H_
+#define HOST_SPI_REGMODEL_H_
+
+#include <stdint.h>
+
+/*
+    Time: core cycles, advanced by every register access (HOST_ACCESS_CYC)
+    and by interrupt entry (HOST_IRQ_CYC). PCLK2 = PCLK1 = SystemCoreClock.
+
+    SPI (master SPI1 wired to slave SPI2, same as the board loopback):
+    - DR write fills the TX buffer (TXE = 0), a master with SPE starts the
+      frame at once or right after the one on the wire (BSY = 1)
+    - One frame takes 8 / 16 x (2 << BR) cycles, then both sides receive
+      what the other shifted out (RXNE = 1). RXNE still set: OVR, data lost
+    - A slave with an empty TX buffer sends 0 (UDR)
+    - CPOL / CPHA / DFF different on the two sides: data arrives inverted
+    - RCC reset clears a SPI back to its reset values
+    DMA: the F446 request mapping (DMA2 S2/S3 ch3 SPI1, DMA1 S3/S4 ch0 SPI2),
+    one item per access, NDTR counts down, TCIFx and EN = 0 at the end.
+    SPI1 interrupt: RXNEIE / TXEIE call SPI1_IRQHandler() between accesses.
+*/
+#define HOST_ACCESS_CYC     2U
+#define HOST_IRQ_CYC        12U
+
+typedef struct
+{
+    uint32_t frames;        // Frames shifted by the master
+    uint32_t ovr;           // Frames lost to an overrun (both sides)
+    uint32_t udr;           // Slave frames sent without data
+    uint32_t irqs;          // SPI1_IRQHandler() calls
+    uint32_t dma_items;     // Items moved by all streams
+} host_spi_stats_t;
+
+extern host_spi_stats_t host_spi_stats;
+extern uint16_t host_spi_flip;          // XORed into every slave -> master frame (fault injection)
+
+void host_model_reset(void);            // Power-on state, SystemCoreClock = 16 MHz HSI
+uint64_t host_cycles(void);
+
+#endif /* HOST_SPI_REGMODEL_H_ */
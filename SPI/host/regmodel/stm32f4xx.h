@@ -0,0 +1,141 @@
+// Host stand-in for the CMSIS device header, used only by the spi_bench host build
+// Just the registers and bits spi_bench.c / regclr.h touch, values as on the STM32F446.
+//
+// Every peripheral macro calls host_tick() first, so core time advances on each
+// register access and the SPI / DMA model (spi_regmodel.c) runs in between.
+// Build with -no-pie: DMA PAR / M0AR take 32-bit addresses, the static buffers
+// and register blocks must sit below 4 GB.
+
+#ifndef HOST_REGMODEL_STM32F4XX_H_
+#define HOST_REGMODEL_STM32F4XX_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+    volatile uint32_t CR1, CR2, SR, DR, CRCPR, RXCRCR, TXCRCR, I2SCFGR, I2SPR;
+} SPI_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CR, NDTR, PAR, M0AR, M1AR, FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t LISR, HISR, LIFCR, HIFCR;
+} DMA_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CFGR, AHB1ENR, APB1ENR, APB2ENR, APB1RSTR, APB2RSTR;
+} RCC_TypeDef;
+
+typedef struct
+{
+    volatile uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+// regclr.h only
+typedef struct { volatile uint32_t PR; } EXTI_TypeDef;
+typedef struct { volatile uint32_t SR; } TIM_TypeDef;
+typedef struct { volatile uint32_t SR; } USART_TypeDef;
+
+typedef enum
+{
+    SPI1_IRQn = 35,
+    SPI2_IRQn = 36
+} IRQn_Type;
+
+/************************************************************/
+
+void host_tick(void);
+
+extern SPI_TypeDef host_spi[2];
+extern DMA_TypeDef host_dma[2];
+extern DMA_Stream_TypeDef host_dma_stream[2][8];
+extern RCC_TypeDef host_rcc;
+extern DWT_Type host_dwt;
+extern CoreDebug_Type host_coredebug;
+extern EXTI_TypeDef host_exti;
+extern uint32_t SystemCoreClock;
+
+#define SPI1            (host_tick(), &host_spi[0])
+#define SPI2            (host_tick(), &host_spi[1])
+#define DMA1            (host_tick(), &host_dma[0])
+#define DMA2            (host_tick(), &host_dma[1])
+#define DMA1_Stream3    (host_tick(), &host_dma_stream[0][3])
+#define DMA1_Stream4    (host_tick(), &host_dma_stream[0][4])
+#define DMA2_Stream2    (host_tick(), &host_dma_stream[1][2])
+#define DMA2_Stream3    (host_tick(), &host_dma_stream[1][3])
+#define RCC             (host_tick(), &host_rcc)
+#define DWT             (host_tick(), &host_dwt)
+#define CoreDebug       (&host_coredebug)
+#define EXTI            (&host_exti)
+
+// CPU reads and writes of SPIx->DR (spi_bench.c), a read clears RXNE
+uint16_t host_spi_dr_read(SPI_TypeDef *spi);
+void host_spi_dr_write(SPI_TypeDef *spi, uint32_t v);
+#define SPI_DR_READ(spi)        host_spi_dr_read(spi)
+#define SPI_DR_WRITE(spi, v)    host_spi_dr_write((spi), (v))
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t prio);
+void NVIC_EnableIRQ(IRQn_Type irq);
+
+/************************************************************/
+
+#define SPI_CR1_CPHA             0x00000001U
+#define SPI_CR1_CPOL             0x00000002U
+#define SPI_CR1_MSTR             0x00000004U
+#define SPI_CR1_BR_Pos           3U
+#define SPI_CR1_BR               0x00000038U
+#define SPI_CR1_SPE              0x00000040U
+#define SPI_CR1_SSI              0x00000100U
+#define SPI_CR1_SSM              0x00000200U
+#define SPI_CR1_DFF              0x00000800U
+
+#define SPI_CR2_RXDMAEN          0x00000001U
+#define SPI_CR2_TXDMAEN          0x00000002U
+#define SPI_CR2_RXNEIE           0x00000040U
+#define SPI_CR2_TXEIE            0x00000080U
+
+#define SPI_SR_RXNE              0x00000001U
+#define SPI_SR_TXE               0x00000002U
+#define SPI_SR_UDR               0x00000008U
+#define SPI_SR_OVR               0x00000040U
+#define SPI_SR_BSY               0x00000080U
+
+#define DMA_SxCR_EN              0x00000001U
+#define DMA_SxCR_TCIE            0x00000010U
+#define DMA_SxCR_DIR             0x000000C0U
+#define DMA_SxCR_DIR_0           0x00000040U
+#define DMA_SxCR_CIRC            0x00000100U
+#define DMA_SxCR_MINC            0x00000400U
+#define DMA_SxCR_PSIZE           0x00001800U
+#define DMA_SxCR_PSIZE_0         0x00000800U
+#define DMA_SxCR_MSIZE           0x00006000U
+#define DMA_SxCR_MSIZE_0         0x00002000U
+#define DMA_SxCR_PL_1            0x00020000U
+#define DMA_SxCR_CHSEL_Pos       25U
+#define DMA_SxCR_CHSEL           0x0E000000U
+
+#define DMA_LISR_TCIF2           0x00200000U
+#define DMA_LISR_TCIF3           0x08000000U
+#define DMA_HISR_TCIF4           0x00000020U
+
+#define RCC_AHB1ENR_DMA1EN       0x00200000U
+#define RCC_AHB1ENR_DMA2EN       0x00400000U
+#define RCC_APB1ENR_SPI2EN       0x00004000U
+#define RCC_APB1RSTR_SPI2RST     0x00004000U
+#define RCC_APB2ENR_SPI1EN       0x00001000U
+#define RCC_APB2RSTR_SPI1RST     0x00001000U
+
+#define DWT_CTRL_CYCCNTENA_Msk       0x00000001U
+#define CoreDebug_DEMCR_TRCENA_Msk   0x01000000U
+
+#endif /* HOST_REGMODEL_STM32F4XX_H_ */
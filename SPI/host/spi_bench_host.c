@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <string.h>
+#include "spi_bench_fmt.h"
+
+/*
+    Host check of spi_bench_fmt.c
+    - PRBS-15 has the full 32767 period and both directions' seeds differ
+    - Bit error count over 8 and 16-bit frame buffers, with injected errors
+    - Throughput / gap math on known numbers
+    - Table lines fit the target's line buffer and keep the column layout
+    Returns 0 when everything matches, prints the failing checks otherwise.
+*/
+
+#define N_FRAMES   256U
+#define LINE_LEN   128U
+
+static unsigned failures;
+
+static void check(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void check_prbs(void)
+{
+    uint16_t state = 0x1234U;
+    uint32_t period = 0;
+
+    do
+    {
+        (void)prbs15(&state, 1U);
+        period++;
+    } while ((state != 0x1234U) && (period <= 0x8000U));
+
+    check(period == 0x7FFFU, "PRBS-15 period is 32767");
+
+    // Master and slave seeds must not send the same pattern
+    uint16_t m = 0x1234U, s = 0x4321U;
+    check(prbs15(&m, 16U) != prbs15(&s, 16U), "PRBS-15 seeds give different patterns");
+}
+
+static void check_bit_errors(uint32_t frame16)
+{
+    uint16_t a[N_FRAMES], b[N_FRAMES];
+    uint32_t bits = frame16 ? 16U : 8U;
+    uint16_t sa = 0x1234U, sb = 0x1234U;
+
+    for (uint32_t i = 0; i < N_FRAMES; i++)
+    {
+        spi_bench_buf_put(a, i, prbs15(&sa, bits), frame16);
+        spi_bench_buf_put(b, i, prbs15(&sb, bits), frame16);
+    }
+
+    check(spi_bench_bit_errors(a, b, N_FRAMES, frame16) == 0U, "same seed, no bit errors");
+
+    // One bit in the first frame, all bits of the last one
+    spi_bench_buf_put(b, 0, spi_bench_buf_get(b, 0, frame16) ^ 1U, frame16);
+    spi_bench_buf_put(b, N_FRAMES - 1U,
+                      (uint16_t)~spi_bench_buf_get(b, N_FRAMES - 1U, frame16), frame16);
+
+    check(spi_bench_bit_errors(a, b, N_FRAMES, frame16) == 1U + bits, "injected bit errors counted");
+}
+
+static void check_rates(void)
+{
+    spi_bench_result_t res;
+
+    memset(&res, 0, sizeof(res));
+
+    // 256 bytes in 16384 cycles at 16 MHz = 250 kB/s, 4096 cycles over ideal = 16 per frame
+    spi_bench_rates(&res, N_FRAMES, 8U, 16000000U, 16384U, 12288U);
+    check(res.kbytes_s == 250U, "kB/s from cycles");
+    check(res.gap_cycles == 16U, "gap per frame");
+
+    // Faster than ideal (clock rounding) is no gap, not a wrap around
+    spi_bench_rates(&res, N_FRAMES, 16U, 16000000U, 1000U, 2000U);
+    check(res.gap_cycles == 0U, "no negative gap");
+}
+
+static void check_table(void)
+{
+    char head[LINE_LEN], row[LINE_LEN];
+    spi_bench_result_t res =
+    {
+        .sck_hz = 8000000U, .kbytes_s = 987U, .gap_cycles = 12U,
+        .lat_min = 0xFFFFFFFFU, .lat_max = 0xFFFFFFFFU, .bit_errors = 4096U, .timeout = 1U
+    };
+    int n;
+
+    spi_bench_fmt_title(head, sizeof(head), 180000000U, N_FRAMES);
+    printf("%s\n", head);
+
+    n = spi_bench_fmt_header(head, sizeof(head));
+    check((n > 0) && ((unsigned)n < LINE_LEN), "header fits the line buffer");
+    printf("%s\n", head);
+
+    // Widest values the target can produce
+    n = spi_bench_fmt_row(row, sizeof(row), SPI_BENCH_POLL, 1U, 3U, 7U, &res);
+    check((n > 0) && ((unsigned)n < LINE_LEN), "widest row fits the line buffer");
+    printf("%s\n", row);
+
+    res.timeout = 0;
+    res.lat_min = 110U;
+    res.lat_max = 140U;
+    res.bit_errors = 0;
+
+    n = spi_bench_fmt_row(row, sizeof(row), SPI_BENCH_DMA, 0U, 0U, 0U, &res);
+    check((n > 0) && (strncmp(row, "DMA     8     0/0    0", 22) == 0), "row layout");
+    check(strlen(row) == strlen(head), "row lines up with the header");
+    printf("%s\n", row);
+}
+
+int main(void)
+{
+    check_prbs();
+    check_bit_errors(0U);
+    check_bit_errors(1U);
+    check_rates();
+    check_table();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
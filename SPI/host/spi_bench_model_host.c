@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include "stm32f4xx.h"
+#include "spi_bench.h"
+#include "spi_regmodel.h"
+
+/*
+    Host run of spi_bench.c on the SPI / DMA register model (regmodel/)
+    - spi_bench_run() prints the full table
+    - POLL and DMA finish without errors for every BR, CPOL/CPHA and frame size,
+      SCK, throughput and latency are consistent with the model's timing
+    - Every DMA stream counts NDTR down to 0, the master shifts exactly the frames asked for
+    - IRQ mode works at the slowest SCK and overruns at the fastest
+    - A corrupted slave -> master line is seen as bit errors
+    Returns 0 when everything matches, prints the failing checks otherwise.
+*/
+
+static unsigned failures;
+
+static void check(int ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static uint32_t mode_bits_of(uint32_t cp)
+{
+    return ((cp & 2U) ? SPI_CR1_CPOL : 0U) | ((cp & 1U) ? SPI_CR1_CPHA : 0U);
+}
+
+/************************************************************/
+
+static void check_sweep(spi_bench_mode_t mode)
+{
+    spi_bench_result_t res;
+    char what[80];
+
+    for (uint32_t frame16 = 0; frame16 < 2U; frame16++)
+    {
+        uint32_t bits = frame16 ? 16U : 8U;
+
+        for (uint32_t cp = 0; cp < 4U; cp++)
+        {
+            for (uint32_t br = 0; br < 8U; br++)
+            {
+                uint32_t frames = host_spi_stats.frames;
+                uint32_t ideal = SPI_BENCH_FRAMES * bits << (br + 1U);
+                uint32_t ideal_kb = (uint32_t)(((uint64_t)SPI_BENCH_FRAMES * (bits / 8U) * SystemCoreClock) /
+                                               ((uint64_t)ideal * 1000U));
+
+                spi_bench_one(mode, br, mode_bits_of(cp), frame16, &res);
+
+                snprintf(what, sizeof(what), "%s %lu-bit cp %lu br %lu",
+                         (mode == SPI_BENCH_DMA) ? "DMA" : "POLL",
+                         (unsigned long)bits, (unsigned long)cp, (unsigned long)br);
+
+                if (res.timeout || (res.bit_errors != 0U))
+                {
+                    check(0, what);
+                    continue;
+                }
+                check(res.sck_hz == (SystemCoreClock >> (br + 1U)), "SCK = PCLK / 2^(BR+1)");
+                check((res.kbytes_s > 0U) && (res.kbytes_s <= ideal_kb), "throughput not above the line rate");
+                check(res.lat_min <= res.lat_max, "latency min <= max");
+                check(res.lat_min >= (bits << (br + 1U)), "latency covers one frame");
+                check((host_spi_stats.frames - frames) == (SPI_BENCH_FRAMES + SPI_BENCH_LAT_RUNS),
+                      "master shifts exactly the frames asked for");
+                check(host_dma_stream[0][3].NDTR == 0U, "slave RX NDTR counted down");
+                check(host_dma_stream[0][4].NDTR == 0U, "slave TX NDTR counted down");
+                if (mode == SPI_BENCH_DMA)
+                {
+                    check(host_dma_stream[1][2].NDTR == 0U, "master RX NDTR counted down");
+                    check(host_dma_stream[1][3].NDTR == 0U, "master TX NDTR counted down");
+                }
+            }
+        }
+    }
+}
+
+static void check_irq(void)
+{
+    spi_bench_result_t res;
+    uint32_t ovr, irqs;
+
+    // Slowest SCK: 256 cycles per frame, plenty for the handler
+    irqs = host_spi_stats.irqs;
+    spi_bench_one(SPI_BENCH_IRQ, 7U, 0U, 0U, &res);
+    check(!res.timeout && (res.bit_errors == 0U), "IRQ at BR 7: no errors");
+    check((host_spi_stats.irqs - irqs) >= SPI_BENCH_FRAMES, "IRQ at BR 7: handler ran per frame");
+
+    // Fastest SCK: a frame is shorter than interrupt entry + handler -> RX overrun
+    ovr = host_spi_stats.ovr;
+    spi_bench_one(SPI_BENCH_IRQ, 0U, 0U, 0U, &res);
+    check(res.timeout != 0U, "IRQ at BR 0 times out");
+    check(host_spi_stats.ovr != ovr, "IRQ at BR 0 overruns");
+}
+
+static void check_fault(void)
+{
+    spi_bench_result_t res;
+
+    host_spi_flip = 0x0001U;
+    spi_bench_one(SPI_BENCH_POLL, 2U, 0U, 0U, &res);
+    host_spi_flip = 0;
+
+    check(!res.timeout, "fault: no timeout");
+    check(res.bit_errors == SPI_BENCH_FRAMES, "fault: one bit error per frame");
+}
+
+int main(void)
+{
+    host_model_reset();
+
+    spi_bench_run();                   // Also enables the clocks and the SPI1 interrupt
+
+    check_sweep(SPI_BENCH_POLL);
+    check_sweep(SPI_BENCH_DMA);
+    check_irq();
+    check_fault();
+
+    printf("frames %lu, overruns %lu, underruns %lu, irqs %lu, DMA items %lu\n",
+           (unsigned long)host_spi_stats.frames, (unsigned long)host_spi_stats.ovr,
+           (unsigned long)host_spi_stats.udr, (unsigned long)host_spi_stats.irqs,
+           (unsigned long)host_spi_stats.dma_items);
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
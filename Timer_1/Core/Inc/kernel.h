@@ -0,0 +1,74 @@
+/*
+ * Small preemptive kernel
+ *
+ * - Fixed priorities, one thread per priority (0 = idle, K_MAX_PRIO-1 = highest)
+ * - Ready queue is a 32-bit bitmap, highest ready thread = one CLZ
+ * - PendSV does the context switch; s16-s31 are saved only for threads that
+ *   used the FPU (EXC_RETURN bit 4), s0-s15 are left to lazy stacking
+ * - Thread API goes through SVC, ISRs call k_signal() directly
+ * - Tickless: TIM5 is a free running 1 MHz counter, CCR1 is programmed to the
+ *   next sleeping thread's wake-up only, the idle thread sleeps in WFI
+ *
+ * Interrupt priorities (NVIC_PRIORITYGROUP_0, 16 levels):
+ *   0 .. K_SYSCALL_PRIO-1  never masked by the kernel, must not call k_* functions
+ *   K_SYSCALL_PRIO .. 14   may call k_signal()
+ *   15                     PendSV (context switch)
+ */
+
+#ifndef INC_KERNEL_H_
+#define INC_KERNEL_H_
+
+#include "stm32f4xx.h"
+
+#define K_MAX_PRIO        32U
+#define K_SYSCALL_PRIO    5U               // BASEPRI level of kernel critical sections
+#define K_TICK_HZ         1000000U         // TIM5 time base, 1 count = 1 us
+#define K_FOREVER         0xFFFFFFFFU
+
+// k_thread_t.state
+#define K_READY           0U
+#define K_SLEEP           1U
+#define K_WAIT            2U
+
+typedef struct k_thread
+{
+	uint32_t *sp;                  // Saved PSP, must stay the first member (PendSV)
+	uint32_t prio;
+	uint32_t state;
+	uint32_t events;               // Posted, not consumed yet
+	uint32_t wait_mask;
+	uint32_t got;                  // Events handed over by the last k_wait()
+	uint32_t wake;                 // Absolute TIM5 count of the timeout
+	struct k_thread *next_sleep;   // Sorted by wake
+	uint32_t runs;                 // Times switched in
+	const char *name;
+} k_thread_t;
+
+typedef struct
+{
+	uint32_t switches;             // Context switches done by PendSV
+	uint32_t fpu_saves;            // ... of which saved s16-s31
+	uint32_t idle_us;              // Time spent in WFI
+	uint32_t wakeups;              // TIM5 compare interrupts
+} k_stats_t;
+
+extern k_stats_t k_stats;
+
+void k_init(void);
+int k_thread_create(k_thread_t *t, uint32_t prio, uint32_t *stack, uint32_t words,
+                    void (*entry)(void *), void *arg, const char *name);
+void k_start(void);                        // Never returns, main's stack is reused
+
+// Threads only (SVC)
+void k_sleep(uint32_t us);
+uint32_t k_wait(uint32_t mask, uint32_t timeout_us);     // 0 = timeout
+
+// Threads and ISRs (priority >= K_SYSCALL_PRIO)
+void k_signal(k_thread_t *t, uint32_t events);
+
+static inline uint32_t k_now(void)
+{
+	return TIM5->CNT;
+}
+
+#endif /* INC_KERNEL_H_ */
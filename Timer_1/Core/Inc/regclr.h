@@ -0,0 +1,82 @@
+/*
+ * Single-write clear primitives for status registers
+ *
+ * Never clear a flag with a read-modify-write (|= or &=):
+ *   rc_w1 (EXTI->PR, DMA LIFCR/HIFCR): PR |= bit reads every pending line and
+ *     writes them back as 1 -> clears flags of other lines too
+ *   rc_w0 (TIMx->SR, USART SR): SR &= ~bit writes back 0 for every flag that
+ *     was still 0 at the read -> a flag set between the read and the write is lost
+ * A plain store of the right pattern touches only the wanted bits.
+ */
+
+#ifndef INC_REGCLR_H_
+#define INC_REGCLR_H_
+
+#include "stm32f4xx.h"
+
+// rc_w1: 1 clears, 0 has no effect
+static inline void reg_clear_w1(volatile uint32_t *reg, uint32_t mask)
+{
+	*reg = mask;
+}
+
+// rc_w0: 0 clears, 1 has no effect
+static inline void reg_clear_w0(volatile uint32_t *reg, uint32_t mask)
+{
+	*reg = ~mask;
+}
+
+// Flags of 'mask' that are set, cleared in the same go (flags set later stay)
+static inline uint32_t reg_take_w1(volatile uint32_t *reg, uint32_t mask)
+{
+	uint32_t f = *reg & mask;
+
+	*reg = f;
+	return f;
+}
+
+static inline uint32_t reg_take_w0(volatile uint32_t *reg, uint32_t mask)
+{
+	uint32_t f = *reg & mask;
+
+	*reg = ~f;
+	return f;
+}
+
+/*==========================================================*/
+
+// EXTI pending lines (rc_w1)
+static inline void exti_pr_clear(uint32_t lines)
+{
+	EXTI->PR = lines;
+}
+
+// TIMx status flags (rc_w0): TIM_SR_UIF, TIM_SR_CC1IF, ...
+static inline void tim_sr_clear(TIM_TypeDef *tim, uint32_t flags)
+{
+	tim->SR = ~flags;
+}
+
+// USART status flags that are rc_w0 (TC, RXNE, LBD, CTS)
+static inline void usart_sr_clear(USART_TypeDef *usart, uint32_t flags)
+{
+	usart->SR = ~flags;
+}
+
+// All five flags (TC, HT, TE, DME, FE) of one DMA stream, LIFCR / HIFCR (rc_w1)
+static inline void dma_stream_clear(DMA_TypeDef *dma, uint32_t stream)
+{
+	static const uint8_t pos[4] = { 0, 6, 16, 22 };
+	uint32_t bits = 0x3DUL << pos[stream & 3U];
+
+	if (stream < 4U)
+	{
+		dma->LIFCR = bits;
+	}
+	else
+	{
+		dma->HIFCR = bits;
+	}
+}
+
+#endif /* INC_REGCLR_H_ */
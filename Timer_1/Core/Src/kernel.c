@@ -0,0 +1,503 @@
+/*
+ * Small preemptive kernel (see kernel.h)
+ */
+
+#include "kernel.h"
+#include "regclr.h"
+
+#define K_BASEPRI         0x50                 // K_SYSCALL_PRIO in the BASEPRI field, plain number for the assembly
+#define K_STR_(x)         #x
+#define K_STR(x)          K_STR_(x)
+
+_Static_assert(K_BASEPRI == (K_SYSCALL_PRIO << (8U - __NVIC_PRIO_BITS)), "K_BASEPRI out of sync with K_SYSCALL_PRIO");
+
+#define K_EXC_RETURN      0xFFFFFFFDU          // Thread mode, PSP, no FPU frame
+#define K_IDLE_WORDS      128U
+
+// SVC numbers (immediate of the svc instruction)
+#define K_SVC_START       0
+#define K_SVC_SLEEP       1
+#define K_SVC_WAIT        2
+#define K_SVC_SIGNAL      3
+
+k_stats_t k_stats;
+
+// Used by the PendSV / SVC assembly, must stay global
+k_thread_t *volatile k_cur;
+
+static k_thread_t *k_prio_tab[K_MAX_PRIO];
+static volatile uint32_t k_ready;              // Bit n set = thread of priority n ready
+static k_thread_t *sleep_head;                 // Sleeping / waiting with timeout, by wake
+static uint8_t k_started;
+
+static k_thread_t idle_thread;
+static uint32_t idle_stack[K_IDLE_WORDS] __attribute__((aligned(8)));
+
+void k_select(void);
+void k_svc_dispatch(uint32_t *frame, uint32_t num);
+
+/*==========================================================*/
+/*
+ * Critical sections mask only interrupts at K_SYSCALL_PRIO and below,
+ * the higher ones keep their latency
+ */
+static uint32_t k_lock(void)
+{
+	uint32_t old = __get_BASEPRI();
+
+	__set_BASEPRI_MAX(K_BASEPRI);
+	__DSB();
+	__ISB();
+	return old;
+}
+
+static void k_unlock(uint32_t old)
+{
+	__set_BASEPRI(old);
+}
+
+static void make_ready(k_thread_t *t)
+{
+	t->state = K_READY;
+	k_ready |= (1U << t->prio);
+}
+
+static void block(k_thread_t *t, uint32_t state)
+{
+	t->state = state;
+	k_ready &= ~(1U << t->prio);
+}
+
+static void sleep_insert(k_thread_t *t)
+{
+	k_thread_t **pp = &sleep_head;
+
+	while ((*pp != 0) && ((int32_t)((*pp)->wake - t->wake) <= 0))
+	{
+		pp = &(*pp)->next_sleep;
+	}
+	t->next_sleep = *pp;
+	*pp = t;
+}
+
+static void sleep_remove(k_thread_t *t)
+{
+	k_thread_t **pp = &sleep_head;
+
+	while (*pp != 0)
+	{
+		if (*pp == t)
+		{
+			*pp = t->next_sleep;
+			return;
+		}
+		pp = &(*pp)->next_sleep;
+	}
+}
+
+/*
+ * Tickless time base: compare only on the first wake-up, no interrupt
+ * at all while no thread has a timeout
+ */
+static void arm_timer(void)
+{
+	if (sleep_head == 0)
+	{
+		TIM5->DIER &= ~TIM_DIER_CC1IE;
+		return;
+	}
+
+	TIM5->CCR1 = sleep_head->wake;
+	TIM5->DIER |= TIM_DIER_CC1IE;
+
+	// Compare only fires on equality: if the time has passed already, run now
+	if ((int32_t)(TIM5->CNT - sleep_head->wake) >= 0)
+	{
+		NVIC_SetPendingIRQ(TIM5_IRQn);
+	}
+}
+
+static void resched(void)
+{
+	if (k_started && (k_prio_tab[31U - __CLZ(k_ready)] != k_cur))
+	{
+		SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+	}
+}
+
+static void signal_locked(k_thread_t *t, uint32_t events)
+{
+	t->events |= events;
+
+	if ((t->state == K_WAIT) && (t->events & t->wait_mask))
+	{
+		t->got = t->events & t->wait_mask;
+		t->events &= ~t->got;
+		sleep_remove(t);
+		make_ready(t);
+		arm_timer();
+	}
+}
+
+/*==========================================================*/
+
+static void k_thread_exit(void)
+{
+	while (1)
+	{
+		k_wait(0, K_FOREVER);
+	}
+}
+
+static void k_idle(void *arg)
+{
+	(void)arg;
+
+	while (1)
+	{
+		// PRIMASK set: a pending interrupt still ends WFI, it runs after __enable_irq()
+		__disable_irq();
+		if (k_ready == 1U)
+		{
+			uint32_t t0 = TIM5->CNT;
+
+			__WFI();
+			k_stats.idle_us += TIM5->CNT - t0;
+		}
+		__enable_irq();
+	}
+}
+
+/*
+ * TIMER5: free running 32-bit counter at K_TICK_HZ, CH1 compare for wake-ups
+ */
+static void k_timer_config(void)
+{
+	uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+	uint32_t timclk;
+
+	SystemCoreClockUpdate();
+	timclk = SystemCoreClock >> APBPrescTable[ppre1];
+	if (APBPrescTable[ppre1] != 0U)
+	{
+		timclk *= 2U;                              // APB1 timers run at 2 x PCLK1
+	}
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+	(void)RCC->APB1ENR;
+
+	TIM5->CR1 &= ~TIM_CR1_CEN;
+	TIM5->PSC = (timclk / K_TICK_HZ) - 1U;
+	TIM5->ARR = 0xFFFFFFFFU;
+	TIM5->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M);
+	TIM5->EGR = TIM_EGR_UG;                        // Load PSC now
+	TIM5->SR = 0;
+	TIM5->CNT = 0;
+
+	NVIC_SetPriority(TIM5_IRQn, K_SYSCALL_PRIO);
+	NVIC_EnableIRQ(TIM5_IRQn);
+
+	TIM5->CR1 |= TIM_CR1_CEN;
+}
+
+void k_init(void)
+{
+	for (uint32_t i = 0; i < K_MAX_PRIO; i++)
+	{
+		k_prio_tab[i] = 0;
+	}
+	k_ready = 0;
+	sleep_head = 0;
+	k_cur = 0;
+	k_started = 0;
+
+	// Lazy FP context: the frame space is reserved, s0-s15 are written only if used
+	FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+
+	// Cycle counter for the measurements
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	NVIC_SetPriority(PendSV_IRQn, 15);
+	NVIC_SetPriority(SVCall_IRQn, K_SYSCALL_PRIO);
+
+	k_timer_config();
+
+	k_thread_create(&idle_thread, 0, idle_stack, K_IDLE_WORDS, k_idle, 0, "idle");
+}
+
+int k_thread_create(k_thread_t *t, uint32_t prio, uint32_t *stack, uint32_t words,
+                    void (*entry)(void *), void *arg, const char *name)
+{
+	if ((prio >= K_MAX_PRIO) || (k_prio_tab[prio] != 0) || (words < 64U))
+	{
+		return -1;
+	}
+
+	// AAPCS: 8 byte aligned stack at the exception return
+	uint32_t *sp = (uint32_t *)((uint32_t)&stack[words] & ~7U);
+
+	// Hardware frame, popped on the first exception return
+	*--sp = 0x01000000U;                           // xPSR, Thumb bit
+	*--sp = (uint32_t)entry & ~1U;                 // PC
+	*--sp = (uint32_t)k_thread_exit;               // LR
+	*--sp = 0;                                     // R12
+	*--sp = 0;                                     // R3
+	*--sp = 0;                                     // R2
+	*--sp = 0;                                     // R1
+	*--sp = (uint32_t)arg;                         // R0
+
+	// Software frame, popped by PendSV: EXC_RETURN, R11 .. R4
+	*--sp = K_EXC_RETURN;
+	for (uint32_t i = 0; i < 8U; i++)
+	{
+		*--sp = 0;
+	}
+
+	t->sp = sp;
+	t->prio = prio;
+	t->events = 0;
+	t->wait_mask = 0;
+	t->got = 0;
+	t->next_sleep = 0;
+	t->runs = 0;
+	t->name = name;
+
+	uint32_t key = k_lock();
+	k_prio_tab[prio] = t;
+	make_ready(t);
+	resched();
+	k_unlock(key);
+
+	return 0;
+}
+
+void k_start(void)
+{
+	k_cur = k_prio_tab[31U - __CLZ(k_ready)];
+	k_cur->runs++;
+	k_started = 1;
+
+	__asm volatile
+	(
+		"	movw r0, #0xED08          \n"   // SCB->VTOR
+		"	movt r0, #0xE000          \n"
+		"	ldr r0, [r0]              \n"
+		"	ldr r0, [r0]              \n"   // Initial MSP: main's stack goes to the handlers
+		"	msr msp, r0               \n"
+		"	mov r0, #0                \n"
+		"	msr control, r0           \n"   // Clear FPCA, main's FP state is dropped
+		"	cpsie i                   \n"
+		"	cpsie f                   \n"
+		"	dsb                       \n"
+		"	isb                       \n"
+		"	svc " K_STR(K_SVC_START) "\n"
+		::: "r0", "memory"
+	);
+
+	while (1);
+}
+
+/*==========================================================*/
+/*
+ * Thread API, one SVC each. Arguments travel in r0 / r1 of the stacked frame.
+ * The switch (PendSV) tail-chains the SVC, so code after the svc runs only
+ * once the thread is scheduled again.
+ */
+
+void k_sleep(uint32_t us)
+{
+	register uint32_t r0 __asm("r0") = us;
+
+	__asm volatile ("svc " K_STR(K_SVC_SLEEP) :: "r" (r0) : "memory");
+}
+
+uint32_t k_wait(uint32_t mask, uint32_t timeout_us)
+{
+	register uint32_t r0 __asm("r0") = mask;
+	register uint32_t r1 __asm("r1") = timeout_us;
+
+	__asm volatile ("svc " K_STR(K_SVC_WAIT) :: "r" (r0), "r" (r1) : "memory");
+
+	return k_cur->got;
+}
+
+void k_signal(k_thread_t *t, uint32_t events)
+{
+	if (__get_IPSR() == 0U)
+	{
+		register uint32_t r0 __asm("r0") = (uint32_t)t;
+		register uint32_t r1 __asm("r1") = events;
+
+		__asm volatile ("svc " K_STR(K_SVC_SIGNAL) :: "r" (r0), "r" (r1) : "memory");
+	}
+	else
+	{
+		uint32_t key = k_lock();
+		signal_locked(t, events);
+		resched();
+		k_unlock(key);
+	}
+}
+
+void k_svc_dispatch(uint32_t *frame, uint32_t num)
+{
+	uint32_t key = k_lock();
+	k_thread_t *t = k_cur;
+
+	switch (num)
+	{
+	case K_SVC_SLEEP:
+		t->wake = TIM5->CNT + frame[0];
+		block(t, K_SLEEP);
+		sleep_insert(t);
+		arm_timer();
+		break;
+
+	case K_SVC_WAIT:
+		t->got = t->events & frame[0];
+		if ((t->got != 0U) || (frame[1] == 0U))
+		{
+			t->events &= ~t->got;                  // Already there or no wait wanted
+			break;
+		}
+		t->wait_mask = frame[0];
+		block(t, K_WAIT);
+		if (frame[1] != K_FOREVER)
+		{
+			t->wake = TIM5->CNT + frame[1];
+			sleep_insert(t);
+			arm_timer();
+		}
+		break;
+
+	case K_SVC_SIGNAL:
+		signal_locked((k_thread_t *)frame[0], frame[1]);
+		break;
+
+	default:
+		break;
+	}
+
+	resched();
+	k_unlock(key);
+}
+
+/*
+ * Called by PendSV with the outgoing context saved in k_cur->sp
+ */
+void k_select(void)
+{
+	k_thread_t *n = k_prio_tab[31U - __CLZ(k_ready)];
+
+	if (n != k_cur)
+	{
+		// Saved EXC_RETURN (above R4-R11): bit 4 clear = s16-s31 were stacked too
+		if ((k_cur->sp[8] & 0x10U) == 0U)
+		{
+			k_stats.fpu_saves++;
+		}
+		k_stats.switches++;
+		n->runs++;
+		k_cur = n;
+	}
+}
+
+/*==========================================================*/
+
+/*
+ * SVC 0 starts the first thread, the others go to k_svc_dispatch(frame, number)
+ */
+__attribute__((naked)) void SVC_Handler(void)
+{
+	__asm volatile
+	(
+		"	tst lr, #4                \n"
+		"	ite eq                    \n"
+		"	mrseq r0, msp             \n"
+		"	mrsne r0, psp             \n"
+		"	ldr r1, [r0, #24]         \n"   // Stacked PC
+		"	ldrb r1, [r1, #-2]        \n"   // svc immediate
+		"	cbz r1, 1f                \n"
+		"	b k_svc_dispatch          \n"   // Tail call, returns with EXC_RETURN
+		"1:	movw r3, #:lower16:k_cur  \n"
+		"	movt r3, #:upper16:k_cur  \n"
+		"	ldr r1, [r3]              \n"
+		"	ldr r0, [r1]              \n"
+		"	ldmia r0!, {r4-r11, lr}   \n"
+		"	msr psp, r0               \n"
+		"	isb                       \n"
+		"	mov r0, #0                \n"
+		"	msr basepri, r0           \n"
+		"	bx lr                     \n"
+	);
+}
+
+/*
+ * Context switch.
+ * If the thread used the FPU the hardware stacked an extended frame (lazily,
+ * s0-s15 are written only when the next FP instruction runs), here only the
+ * callee saved s16-s31 are added, and only for those threads.
+ */
+__attribute__((naked)) void PendSV_Handler(void)
+{
+	__asm volatile
+	(
+		"	mrs r0, psp               \n"
+		"	isb                       \n"
+		"	movw r3, #:lower16:k_cur  \n"
+		"	movt r3, #:upper16:k_cur  \n"
+		"	ldr r2, [r3]              \n"
+		"	tst lr, #0x10             \n"
+		"	it eq                     \n"
+		"	vstmdbeq r0!, {s16-s31}   \n"
+		"	stmdb r0!, {r4-r11, lr}   \n"
+		"	str r0, [r2]              \n"
+
+		"	mov r0, #" K_STR(K_BASEPRI) "\n"
+		"	msr basepri, r0           \n"
+		"	dsb                       \n"
+		"	isb                       \n"
+		"	bl k_select               \n"
+		"	mov r0, #0                \n"
+		"	msr basepri, r0           \n"
+
+		"	movw r3, #:lower16:k_cur  \n"
+		"	movt r3, #:upper16:k_cur  \n"
+		"	ldr r1, [r3]              \n"
+		"	ldr r0, [r1]              \n"
+		"	ldmia r0!, {r4-r11, lr}   \n"
+		"	tst lr, #0x10             \n"
+		"	it eq                     \n"
+		"	vldmiaeq r0!, {s16-s31}   \n"
+		"	msr psp, r0               \n"
+		"	isb                       \n"
+		"	bx lr                     \n"
+	);
+}
+
+void TIM5_IRQHandler(void)
+{
+	tim_sr_clear(TIM5, TIM_SR_CC1IF);              // rc_w0: clears only CC1IF
+
+	uint32_t key = k_lock();
+	uint32_t now = TIM5->CNT;
+
+	while ((sleep_head != 0) && ((int32_t)(now - sleep_head->wake) >= 0))
+	{
+		k_thread_t *t = sleep_head;
+
+		sleep_head = t->next_sleep;
+		if (t->state == K_WAIT)
+		{
+			t->got = 0;                            // Timed out
+		}
+		make_ready(t);
+	}
+	k_stats.wakeups++;
+
+	arm_timer();
+	resched();
+	k_unlock(key);
+}
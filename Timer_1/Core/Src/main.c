@@ -1,25 +1,81 @@
 /*
- * LED Delay using TIM2 (polling)
+ * Preemptive kernel demo + latency harness (see kernel.h)
+ *
+ * Threads (higher number = higher priority):
+ *   6 irq   woken by TIM2_IRQHandler every 1 ms
+ *   5 pong  woken by ping, measures the switch
+ *   4 ping  every 10 ms
+ *   3 led   toggles PA5 every 1 s (was TIM2 polling)
+ *   1 fpu   floating point bursts, its switches save s16-s31
+ *   0 idle  (kernel) WFI, tickless
+ *
+ * Results are published in 'bench' and 'k_stats' (watch them in the debugger).
+ * All numbers are CPU cycles.
+ *   bench.irq        TIM2 update event -> first line of TIM2_IRQHandler
+ *   bench.irq_thread TIM2 update event -> irq thread running (ISR + k_signal + PendSV)
+ *   bench.ctx        k_signal() in ping -> pong running (SVC + PendSV)
  */
 #include "stm32f4xx.h"
+#include "kernel.h"
+#include "regclr.h"
+
+#define EVT_TICK      (1U << 0)
+#define EVT_PING      (1U << 1)
+
+#define STACK_WORDS   256U
+
+typedef struct
+{
+	uint32_t min;
+	uint32_t max;
+	uint32_t last;
+	uint32_t n;
+	uint64_t sum;                  // avg = sum / n
+} lat_t;
+
+typedef struct
+{
+	lat_t irq;
+	lat_t irq_thread;
+	lat_t ctx;
+} bench_t;
+
+volatile bench_t bench;
+volatile float fpu_result;
+
+static k_thread_t irq_thr, pong_thr, ping_thr, led_thr, fpu_thr;
+static uint32_t irq_stack[STACK_WORDS] __attribute__((aligned(8)));
+static uint32_t pong_stack[STACK_WORDS] __attribute__((aligned(8)));
+static uint32_t ping_stack[STACK_WORDS] __attribute__((aligned(8)));
+static uint32_t led_stack[STACK_WORDS] __attribute__((aligned(8)));
+static uint32_t fpu_stack[STACK_WORDS] __attribute__((aligned(8)));
+
+static volatile uint32_t ping_t0;
+static uint32_t cyc_per_count;                 // Core cycles per TIM2 count
 
 static void gpio_config(void);
 static void timer_config(void);
+static void lat_add(volatile lat_t *l, uint32_t v);
+static void irq_task(void *arg);
+static void pong_task(void *arg);
+static void ping_task(void *arg);
+static void led_task(void *arg);
+static void fpu_task(void *arg);
 
 int main(void)
 {
 	gpio_config();
-	timer_config();
 
-	while(1)
-	{
-		if((TIM2->SR) & TIM_SR_UIF)
-			{
-				TIM2->SR &= ~(TIM_SR_UIF);                       //clearing UIF flag (without touching other bits)
-				GPIOA->ODR ^= (1U << 5);                      //LED Toggle
-			}
+	k_init();
+	k_thread_create(&irq_thr, 6, irq_stack, STACK_WORDS, irq_task, 0, "irq");
+	k_thread_create(&pong_thr, 5, pong_stack, STACK_WORDS, pong_task, 0, "pong");
+	k_thread_create(&ping_thr, 4, ping_stack, STACK_WORDS, ping_task, 0, "ping");
+	k_thread_create(&led_thr, 3, led_stack, STACK_WORDS, led_task, 0, "led");
+	k_thread_create(&fpu_thr, 1, fpu_stack, STACK_WORDS, fpu_task, 0, "fpu");
 
-	}
+	timer_config();
+
+	k_start();
 }
 
 static void gpio_config(void)
@@ -40,18 +96,114 @@ static void gpio_config(void)
 
 }
 
+/*
+ * TIM2 as latency probe: PSC = 0 so the counter runs at the timer clock and
+ * restarts from 0 on every update event; CNT read in the ISR = delay since the event
+ */
 static void timer_config(void)
 {
-	//  is on AHB1 bus
+	uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+	uint32_t timclk = SystemCoreClock >> APBPrescTable[ppre1];
+
+	if (APBPrescTable[ppre1] != 0U)
+	{
+		timclk *= 2U;                         // APB1 timers run at 2 x PCLK1
+	}
+	cyc_per_count = SystemCoreClock / timclk; // 1 with the default 16 MHz HSI
+
+	//  is on APB1 bus
 	RCC->APB1ENR |=RCC_APB1ENR_TIM2EN ;      //Enableing the clock for TIMER2
 	(void)RCC->APB1ENR;                       // read-back to ensure clock is active
 
 	TIM2->CR1 &= ~(TIM_CR1_CEN);               //Disableing the TIM2
 
-	TIM2->PSC = 15999;                       //setting prescaler value (for 16MHz clk freq) , at this value the tick period 1000Hz (1msec)
-	TIM2->ARR = 1000;                        //setting ARR to 1000 (0-1000) , at this value the overflow time 1000 x 1mHz = 1sec
+	TIM2->PSC = 0;                           //Counter at the timer clock
+	TIM2->ARR = (timclk / 1000U) - 1U;       //Update event every 1 ms
 
-	TIM2->SR &= ~TIM_SR_UIF;                       //clearing UIF flag
+	tim_sr_clear(TIM2, TIM_SR_UIF);          //clearing UIF flag (rc_w0, other flags untouched)
+	TIM2->DIER |= TIM_DIER_UIE;
+
+	NVIC_SetPriority(TIM2_IRQn, K_SYSCALL_PRIO + 1U);   // Calls k_signal()
+	NVIC_EnableIRQ(TIM2_IRQn);
 
 	TIM2->CR1 |= TIM_CR1_CEN;               //Enableing the TIM2
 }
+
+static void lat_add(volatile lat_t *l, uint32_t v)
+{
+	if ((l->n == 0U) || (v < l->min))
+	{
+		l->min = v;
+	}
+	if (v > l->max)
+	{
+		l->max = v;
+	}
+	l->last = v;
+	l->sum += v;
+	l->n++;
+}
+
+/*==========================================================*/
+
+static void irq_task(void *arg)
+{
+	while (1)
+	{
+		k_wait(EVT_TICK, K_FOREVER);
+		lat_add(&bench.irq_thread, TIM2->CNT * cyc_per_count);
+	}
+}
+
+static void pong_task(void *arg)
+{
+	while (1)
+	{
+		k_wait(EVT_PING, K_FOREVER);
+		lat_add(&bench.ctx, DWT->CYCCNT - ping_t0);
+	}
+}
+
+static void ping_task(void *arg)
+{
+	while (1)
+	{
+		k_sleep(10000);
+		ping_t0 = DWT->CYCCNT;
+		k_signal(&pong_thr, EVT_PING);
+	}
+}
+
+static void led_task(void *arg)
+{
+	while (1)
+	{
+		k_sleep(1000000);
+		GPIOA->ODR ^= (1U << 5);                      //LED Toggle
+	}
+}
+
+static void fpu_task(void *arg)
+{
+	float x = 1.0f;
+
+	while (1)
+	{
+		// ~ a few ms of FP work, preempted by every thread above
+		for (uint32_t i = 0; i < 20000U; i++)
+		{
+			x = (x * 0.9999f) + 0.001f;
+		}
+		fpu_result = x;
+		k_sleep(5000);
+	}
+}
+
+void TIM2_IRQHandler(void)
+{
+	uint32_t cnt = TIM2->CNT;                          // first: counts since the update event
+
+	tim_sr_clear(TIM2, TIM_SR_UIF);                    // rc_w0: clears only UIF
+	lat_add(&bench.irq, cnt * cyc_per_count);
+	k_signal(&irq_thr, EVT_TICK);
+}
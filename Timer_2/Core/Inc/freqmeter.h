@@ -0,0 +1,47 @@
+/*
+ * Auto-ranging frequency / period meter
+ *
+ * Low range  (up to FM_LOW_MAX_HZ): PWM input on TIM3 CH1, PA6 (AF2)
+ *   - TI1 rising edge resets the counter (slave reset mode) and captures
+ *     the period into CCR1, the falling edge captures the high time into CCR2
+ *   - Prescaler steps through FM_PSC_STEPS as the period grows (down to ~1 Hz)
+ *
+ * High range (above FM_HIGH_MIN_HZ): edge counting on TIM1 ETR, PA12 (AF1)
+ *   - TIM1 external clock mode 2, gated by the TIM4 TRGO (ITR3)
+ *   - TIM4 one-pulse, OC1REF = gate of FM_GATE_MS, its update ends the measurement
+ *   - TIM1 overflows are counted, range up to ~timer clock / 4
+ *
+ * The meter switches range by itself (hysteresis between the two limits).
+ * Results go into a ring buffer, read them with fm_read().
+ *
+ * Wiring: the signal goes to PA6 AND PA12 (both 3.3 V logic).
+ */
+
+#ifndef INC_FREQMETER_H_
+#define INC_FREQMETER_H_
+
+#include "stm32f4xx.h"
+
+#define FM_LOW_MAX_HZ    12000U      // Low -> high range above this
+#define FM_HIGH_MIN_HZ   8000U       // High -> low range below this
+#define FM_GATE_MS       100U        // High range gate time, resolution = 1 / gate
+#define FM_RING_LEN      16U         // Results kept, power of two
+
+typedef enum
+{
+	FM_LOW = 0,                      // Period measurement (PWM input)
+	FM_HIGH                          // Gated edge count
+} fm_range_t;
+
+typedef struct
+{
+	uint64_t freq_mhz;               // Frequency in mHz, 0 = no signal
+	uint16_t duty;                   // High time in 1/1000 of the period (low range only)
+	uint8_t  range;                  // fm_range_t that measured it
+} fm_result_t;
+
+void fm_init(void);
+uint8_t fm_read(fm_result_t *r);     // 1 = result returned, 0 = ring empty
+uint32_t fm_lost(void);              // Results dropped because the ring was full
+
+#endif /* INC_FREQMETER_H_ */
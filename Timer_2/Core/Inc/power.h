@@ -0,0 +1,56 @@
+/*
+ * Idle / power manager with sleep accounting
+ *
+ * Main loop idle: pwr_idle() is called with interrupts disabled (PRIMASK)
+ * after the loop found nothing to do, so an interrupt between the check and
+ * the sleep cannot be missed: a pending interrupt wakes WFI / WFE even while
+ * masked. It returns still masked; the interrupt runs at the caller's
+ * __enable_irq(), after the clocks are restored and the sleep is accounted.
+ *   PWR_SLEEP      WFI, core clock stopped, peripherals / DMA keep running
+ *   PWR_SLEEP_WFE  WFE with SEVONPEND: also woken by interrupts that are
+ *                  disabled in the NVIC (peripheral flag polled afterwards)
+ *   PWR_STOP       Deep sleep, all clocks off, only EXTI lines wake up;
+ *                  HSE / PLL / SYSCLK source are restored before returning
+ *                  (timers, PWM, DMA and UART stop, so only for EXTI-driven apps)
+ *
+ * Pure interrupt applications: pwr_sleep_on_exit() never returns, the core
+ * goes back to sleep after every ISR (SLEEPONEXIT) without running thread code.
+ * Those ISRs call pwr_isr_enter() / pwr_isr_exit() to get the awake time counted.
+ *
+ * Accounting in DWT->CYCCNT core clocks, which keep counting in Sleep but not
+ * in Stop (STOP intervals are only counted in 'stops'). One interval longer than
+ * 2^32 clocks (268 s at 16 MHz) is counted modulo 2^32.
+ */
+
+#ifndef INC_POWER_H_
+#define INC_POWER_H_
+
+#include "stm32f4xx.h"
+
+typedef enum
+{
+	PWR_SLEEP = 0,
+	PWR_SLEEP_WFE,
+	PWR_STOP
+} pwr_mode_t;
+
+typedef struct
+{
+	uint64_t awake_cyc;
+	uint64_t sleep_cyc;
+	uint32_t sleeps;                   // WFI / WFE entries, sleep-on-exit wake-ups
+	uint32_t stops;
+} pwr_stats_t;
+
+extern volatile pwr_stats_t pwr_stats;
+
+void pwr_init(void);                   // Cycle counter, PWR clock, statistics cleared
+void pwr_idle(pwr_mode_t mode);        // Interrupts disabled on entry and on return
+void pwr_sleep_on_exit(void);          // Never returns
+
+void pwr_isr_enter(void);              // Sleep-on-exit accounting, no effect otherwise
+void pwr_isr_exit(void);
+
+uint32_t pwr_duty_permille(void);      // Awake share of the accounted time, 0..1000
+
+#endif /* INC_POWER_H_ */
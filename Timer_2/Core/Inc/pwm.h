@@ -0,0 +1,32 @@
+/*
+ * PWM LED driver on PA5 (TIM2_CH1, AF1)
+ *
+ * - TIM2 CH1 in PWM mode 1 with CCR1 / ARR preload, PWM_HZ carrier
+ * - DMA1 Stream1 Channel3 (TIM2_UP) writes the next CCR1 value on every
+ *   update event: one sequence entry per PWM period, no CPU involved
+ * - Brightness 0 .. 255 is mapped through a gamma table (PWM_GAMMA)
+ * - Patterns are expanded into a RAM sequence, looped (circular DMA) or
+ *   played once (the last level then stays)
+ */
+
+#ifndef INC_PWM_H_
+#define INC_PWM_H_
+
+#include "stm32f4xx.h"
+
+#define PWM_HZ         500U            // Carrier, 1 sequence entry = 2 ms
+#define PWM_TOP        999U            // ARR, PWM_TOP + 1 duty steps
+#define PWM_GAMMA      2.2f
+#define PWM_SEQ_MAX    2048U           // Entries (words), longest pattern = 4 s
+
+void pwm_init(void);
+
+// Fixed brightness, stops any running pattern
+void pwm_set(uint8_t level);
+
+// Patterns, return -1 if the pattern does not fit in PWM_SEQ_MAX entries
+int pwm_breathe(uint32_t period_ms);                              // 0 -> 255 -> 0, looped
+int pwm_blink(uint32_t on_ms, uint32_t off_ms, uint8_t level);    // looped
+int pwm_fade(uint8_t from, uint8_t to, uint32_t time_ms);         // once
+
+#endif /* INC_PWM_H_ */
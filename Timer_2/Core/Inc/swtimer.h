@@ -0,0 +1,38 @@
+/*
+ * Software timers on one hardware compare channel (TIM5 CH1)
+ *
+ * - TIM5 is a free running 32-bit counter, 1 count = 1 ms
+ * - Timers live in a hashed timing wheel (SWT_WHEEL_SIZE slots, slot = expiry % size)
+ * - Start / stop are O(1) (intrusive doubly linked lists + slot bitmap)
+ * - No periodic tick: CCR1 is programmed to the next non-empty slot only
+ * - Callbacks run inside TIM5_IRQHandler, keep them short
+ */
+
+#ifndef INC_SWTIMER_H_
+#define INC_SWTIMER_H_
+
+#include "stm32f4xx.h"
+
+#define SWT_TICK_HZ      1000U       // Timer resolution (1 ms)
+#define SWT_WHEEL_SIZE   256U        // Power of two, at most 32 x 32 slots
+
+typedef void (*swt_cb_t)(void *arg);
+
+// Owned by the caller (static or global), never copied while running
+typedef struct swtimer
+{
+	struct swtimer *next;
+	struct swtimer *prev;
+	uint32_t expiry;               // Absolute tick
+	uint32_t period;               // 0 = one-shot
+	swt_cb_t cb;
+	void *arg;
+	uint8_t active;
+} swtimer_t;
+
+void swt_init(void);
+void swt_start(swtimer_t *t, uint32_t delay_ms, uint32_t period_ms, swt_cb_t cb, void *arg);
+void swt_stop(swtimer_t *t);
+uint32_t swt_now(void);            // Current tick (ms)
+
+#endif /* INC_SWTIMER_H_ */
@@ -0,0 +1,330 @@
+/*
+ * Auto-ranging frequency / period meter (see freqmeter.h)
+ */
+
+#include "freqmeter.h"
+#include "regclr.h"
+
+#define FM_PSC_COUNT     3U
+#define FM_MIN_COUNTS    4096U       // Low range: fewer counts per period -> smaller prescaler
+#define FM_GATE_TICK_HZ  10000U      // TIM4 counts 100 us
+
+static const uint16_t fm_psc[FM_PSC_COUNT] = { 0, 15, 255 };   // TIM3 prescalers, shortest period first
+
+static fm_result_t ring[FM_RING_LEN];
+static volatile uint32_t ring_wr;    // Written by the ISRs only
+static volatile uint32_t ring_rd;    // Written by fm_read() only
+static volatile uint32_t lost;
+
+static uint32_t timclk;
+static uint8_t range;
+static uint8_t psc_idx;
+static uint8_t skip;                 // Captures to ignore after a (re)start
+static uint32_t ovf;                 // TIM1 overflows in the current gate
+
+/*==========================================================*/
+
+static void push(uint64_t freq_mhz, uint16_t duty)
+{
+	uint32_t wr = ring_wr;
+
+	if ((wr - ring_rd) >= FM_RING_LEN)
+	{
+		lost++;
+		return;
+	}
+	ring[wr & (FM_RING_LEN - 1U)].freq_mhz = freq_mhz;
+	ring[wr & (FM_RING_LEN - 1U)].duty = duty;
+	ring[wr & (FM_RING_LEN - 1U)].range = range;
+	__DMB();                                   // Entry complete before it is published
+	ring_wr = wr + 1U;
+}
+
+uint8_t fm_read(fm_result_t *r)
+{
+	uint32_t rd = ring_rd;
+
+	if (rd == ring_wr)
+	{
+		return 0;
+	}
+	__DMB();
+	*r = ring[rd & (FM_RING_LEN - 1U)];
+	ring_rd = rd + 1U;
+	return 1;
+}
+
+uint32_t fm_lost(void)
+{
+	return lost;
+}
+
+/*==========================================================*/
+/*
+ * Timer clocks: APB prescaler = 1 -> PCLK, > 1 -> 2 x PCLK.
+ * TIM3 / TIM4 are on APB1, TIM1 on APB2; only the APB1 clock is needed
+ * (TIM1 counts external edges).
+ */
+
+static uint32_t apb1_timer_clock(void)
+{
+	uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+
+	SystemCoreClockUpdate();
+
+	if (APBPrescTable[ppre1] == 0U)
+	{
+		return SystemCoreClock;
+	}
+	return (SystemCoreClock >> APBPrescTable[ppre1]) * 2U;
+}
+
+static void fm_gpio_config(void)
+{
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;
+	(void)RCC->AHB1ENR;
+
+	// PA6 -> AF2 (TIM3_CH1)
+	GPIOA->MODER &= ~(3U << 12);
+	GPIOA->MODER |= (2U << 12);
+	GPIOA->PUPDR &= ~(3U << 12);
+	GPIOA->AFR[0] &= ~(0xFU << 24);
+	GPIOA->AFR[0] |= (2U << 24);
+
+	// PA12 -> AF1 (TIM1_ETR)
+	GPIOA->MODER &= ~(3U << 24);
+	GPIOA->MODER |= (2U << 24);
+	GPIOA->PUPDR &= ~(3U << 24);
+	GPIOA->AFR[1] &= ~(0xFU << 16);
+	GPIOA->AFR[1] |= (1U << 16);
+}
+
+/*==========================================================*/
+/*
+ * Low range, TIMER3 PWM input
+ * - CC1S = 01 (TI1), rising  -> CCR1 = period
+ * - CC2S = 10 (TI1), falling -> CCR2 = high time
+ * - SMS = 100 (reset), TS = 101 (TI1FP1): every rising edge restarts the count
+ * - URS = 1: only a real overflow (no edge for a whole ARR) sets UIF
+ */
+
+static void low_start(void)
+{
+	TIM3->CR1 &= ~TIM_CR1_CEN;
+
+	TIM3->PSC = fm_psc[psc_idx];
+	TIM3->ARR = 0xFFFF;
+	TIM3->EGR = TIM_EGR_UG;                    // Load PSC
+	TIM3->SR = 0;
+	TIM3->CNT = 0;
+	skip = 1;                                  // First period is partial
+
+	TIM3->DIER = TIM_DIER_CC1IE | TIM_DIER_UIE;
+	TIM3->CR1 |= TIM_CR1_CEN;
+}
+
+static void low_config(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+	(void)RCC->APB1ENR;
+
+	TIM3->CR1 = TIM_CR1_URS;
+	TIM3->CCER = 0;
+	TIM3->CCMR1 = (1U << TIM_CCMR1_CC1S_Pos) | (2U << TIM_CCMR1_CC2S_Pos);
+	TIM3->CCER = TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC2P;
+	TIM3->SMCR = (5U << TIM_SMCR_TS_Pos) | (4U << TIM_SMCR_SMS_Pos);
+
+	NVIC_SetPriority(TIM3_IRQn, 2);
+	NVIC_EnableIRQ(TIM3_IRQn);
+}
+
+static void low_stop(void)
+{
+	TIM3->CR1 &= ~TIM_CR1_CEN;
+	TIM3->DIER = 0;
+}
+
+/*==========================================================*/
+/*
+ * High range
+ * - TIMER4 one-pulse, PWM mode 2: OC1REF high from CCR1 = 1 to ARR, low while
+ *   stopped -> gate of exactly ARR ticks; MMS = 100 puts OC1REF on TRGO
+ * - TIMER1 ECE = 1 (ETR edges clock the counter), SMS = 101 (gated), TS = 011 (ITR3 = TIM4)
+ */
+
+static void high_start(void)
+{
+	TIM1->CNT = 0;
+	ovf = 0;
+	TIM4->CNT = 0;
+	TIM4->CR1 |= TIM_CR1_CEN;
+}
+
+static void high_config(void)
+{
+	RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;
+	RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+	(void)RCC->APB2ENR;
+
+	TIM4->CR1 = TIM_CR1_OPM;
+	TIM4->PSC = (timclk / FM_GATE_TICK_HZ) - 1U;
+	TIM4->ARR = (FM_GATE_MS * FM_GATE_TICK_HZ) / 1000U;
+	TIM4->CCR1 = 1;
+	TIM4->CCMR1 = (7U << TIM_CCMR1_OC1M_Pos);
+	TIM4->CR2 = (4U << TIM_CR2_MMS_Pos);
+	TIM4->EGR = TIM_EGR_UG;
+	TIM4->SR = 0;
+
+	TIM1->CR1 = 0;
+	TIM1->PSC = 0;
+	TIM1->ARR = 0xFFFF;
+	TIM1->RCR = 0;
+	TIM1->EGR = TIM_EGR_UG;
+	TIM1->SR = 0;
+	TIM1->SMCR = TIM_SMCR_ECE | (3U << TIM_SMCR_TS_Pos) | (5U << TIM_SMCR_SMS_Pos);
+	TIM1->CR1 = TIM_CR1_URS | TIM_CR1_CEN;     // Only overflows set UIF; counts only while gated
+
+	NVIC_SetPriority(TIM1_UP_TIM10_IRQn, 1);   // Before the gate end is handled
+	NVIC_EnableIRQ(TIM1_UP_TIM10_IRQn);
+	NVIC_SetPriority(TIM4_IRQn, 2);
+	NVIC_EnableIRQ(TIM4_IRQn);
+}
+
+static void high_run(uint8_t on)
+{
+	if (on)
+	{
+		TIM1->DIER = TIM_DIER_UIE;
+		TIM4->DIER = TIM_DIER_UIE;
+		high_start();
+	}
+	else
+	{
+		TIM4->CR1 &= ~TIM_CR1_CEN;
+		TIM4->DIER = 0;
+		TIM1->DIER = 0;
+	}
+}
+
+/*==========================================================*/
+
+static void set_range(uint8_t r)
+{
+	range = r;
+	if (r == FM_HIGH)
+	{
+		low_stop();
+		high_run(1);
+	}
+	else
+	{
+		high_run(0);
+		psc_idx = 0;
+		low_start();
+	}
+}
+
+void fm_init(void)
+{
+	ring_wr = 0;
+	ring_rd = 0;
+	lost = 0;
+	timclk = apb1_timer_clock();
+
+	fm_gpio_config();
+	low_config();
+	high_config();
+
+	set_range(FM_LOW);
+}
+
+/*==========================================================*/
+
+void TIM3_IRQHandler(void)
+{
+	uint32_t sr = TIM3->SR;
+
+	if (sr & TIM_SR_CC1IF)
+	{
+		uint32_t period = TIM3->CCR1;          // Reading CCR1 clears CC1IF
+		uint32_t high = TIM3->CCR2;
+
+		tim_sr_clear(TIM3, TIM_SR_UIF);        // A wrap in the same period is no timeout
+
+		if (skip != 0U)
+		{
+			skip--;
+			return;
+		}
+		if (period == 0U)
+		{
+			return;
+		}
+
+		uint64_t f = ((uint64_t)timclk * 1000U) / ((uint64_t)(fm_psc[psc_idx] + 1U) * period);
+
+		// Too few counts: finer prescaler, or the high range at the finest one
+		if (period < FM_MIN_COUNTS)
+		{
+			if (psc_idx > 0U)
+			{
+				psc_idx--;
+				low_start();
+			}
+			else if (f > ((uint64_t)FM_LOW_MAX_HZ * 1000U))
+			{
+				set_range(FM_HIGH);
+				return;
+			}
+		}
+
+		push(f, (uint16_t)((high * 1000U) / period));
+	}
+	else if (sr & TIM_SR_UIF)
+	{
+		// No rising edge for a whole 16-bit period
+		tim_sr_clear(TIM3, TIM_SR_UIF);
+		if ((psc_idx + 1U) < FM_PSC_COUNT)
+		{
+			psc_idx++;
+			low_start();
+		}
+		else
+		{
+			push(0, 0);                        // Below ~1 Hz: no signal
+		}
+	}
+}
+
+void TIM1_UP_TIM10_IRQHandler(void)
+{
+	if (TIM1->SR & TIM_SR_UIF)
+	{
+		tim_sr_clear(TIM1, TIM_SR_UIF);
+		ovf++;
+	}
+}
+
+void TIM4_IRQHandler(void)
+{
+	tim_sr_clear(TIM4, TIM_SR_UIF);            // Gate closed, TIM4 stopped (one-pulse)
+
+	// An overflow right at the gate end may still be pending
+	if (TIM1->SR & TIM_SR_UIF)
+	{
+		tim_sr_clear(TIM1, TIM_SR_UIF);
+		ovf++;
+	}
+
+	uint64_t edges = ((uint64_t)ovf << 16) | TIM1->CNT;
+	uint64_t f = (edges * 1000000U) / FM_GATE_MS;   // mHz
+
+	if (f < ((uint64_t)FM_HIGH_MIN_HZ * 1000U))
+	{
+		set_range(FM_LOW);
+		return;
+	}
+
+	push(f, 0);
+	high_start();
+}
@@ -1,69 +1,77 @@
 /*
- * Generating perodic interrupt using TIM2 (NVIC + ISR)
+ * LED dimming with hardware PWM on PA5 (TIM2_CH1, see pwm.h)
+ * A software timer (TIM5 CH1 compare wheel, see swtimer.h) switches
+ * the pattern; the patterns themselves run on DMA without the CPU.
+ *
+ * Frequency meter (see freqmeter.h): signal on PA6 + PA12, the latest
+ * result is kept in 'freq' (watch it in the debugger).
+ *
+ * Between interrupts the core sleeps (power.h), awake / asleep time in pwr_stats.
  */
 #include "stm32f4xx.h"
+#include "swtimer.h"
+#include "pwm.h"
+#include "freqmeter.h"
+#include "power.h"
 
-static void gpio_config(void);
-static void timer_config(void);
-static void nvic_config(void);
+#define PATTERN_MS   6000U
 
-int main()
-{
-	gpio_config();
-    timer_config();
-
-	while(1);
-}
-
-static void gpio_config(void)
-{
-	// GPIOA is on AHB1 bus
-	RCC->AHB1ENR |=RCC_AHB1ENR_GPIOAEN ;      //Enableing the clock for GPIOA
-	(void)RCC->AHB1ENR;                       // read-back to ensure clock is active
+static void next_pattern(void *arg);
 
-	GPIOA->MODER &= ~(3U << 10);             //Clearing the moder PA5 bits
-	GPIOA->MODER |= (1U << 10);              // setting the moder  PA5 bits as output configuration
+static swtimer_t pattern_tmr;
+static uint32_t pattern;
 
-	GPIOA->ODR &= ~(1U << 5);                    //LED OFF state at initiation
+volatile fm_result_t freq;
 
-	GPIOA->OTYPER &= ~(1U << 5);               //Push -Pull type
-
-	GPIOA->OSPEEDR &= ~(3U << 10);           //Clearing the output speed PA5 bits
-
-	GPIOA->PUPDR &= ~(3U << 10);            //Clearing the PA5 PUPDR bits
-}
-
-static void timer_config(void)
-{
-	// TIMER is on APB1 bus
-	RCC->APB1ENR |=RCC_APB1ENR_TIM2EN ;      //Enableing the clock for TIMER2
-	(void)RCC->APB1ENR;                       // read-back to ensure clock is active
-
-	TIM2->CR1 &= ~(TIM_CR1_CEN);               //Disabling  the TIM2
-
-	TIM2->PSC = 15999;                       //setting prescaler value (for 16MHz clk freq) , at this value the tick period 1000Hz (1msec)
-	TIM2->ARR = 1000;                        //setting ARR to 1000 (0-1000) , at this value the overflow time 1000 x 1mHz = 1sec
-
-	//TIM2->DIER &= ~(TIM_DIER_UIE);           //clearing the UIE bit
-	TIM2->DIER |= (TIM_DIER_UIE);              //Seting the UIE flag to fire an interrupt
-
-	TIM2->SR &= ~TIM_SR_UIF;                   //clearing UIF flag
-
-	nvic_config();
-
-	TIM2->CR1 |= TIM_CR1_CEN;               //Enableing the TIM2
-}
-
-static void nvic_config(void)
+int main()
 {
-	NVIC->ISER[0] |= (1U << 28);              //setting the ISER register 28th position or 28th interrupt (TIM2 Interrupt)
-
-	NVIC->IP[28] &= ~(16U << 4);             //clearing the IPR[28] register of offset 0
-	NVIC->IP[28] |= (1 << 4);              //setting the IPR[28] register of offset 0
+	pwr_init();
+	pwm_init();
+	swt_init();
+
+	next_pattern(0);
+	swt_start(&pattern_tmr, PATTERN_MS, PATTERN_MS, next_pattern, 0);
+
+	fm_init();
+
+	while(1)
+	{
+		fm_result_t r;
+		uint8_t got;
+
+		// Results arrive from the timer interrupts: checked with interrupts off,
+		// so one arriving just now cannot be slept through
+		__disable_irq();
+		got = fm_read(&r);
+		if (!got)
+		{
+			pwr_idle(PWR_SLEEP);               // PWM / DMA / timers keep running
+		}
+		__enable_irq();
+
+		if (got)
+		{
+			freq = r;
+		}
+	}
 }
 
-void TIM2_IRQHandler(void)
+static void next_pattern(void *arg)
 {
-	TIM2->SR &= ~(TIM_SR_UIF);                       //clearing UIF flag (without touching other bits)
-	GPIOA->ODR ^= (1U <<5);                    // Toggling LED
+	(void)arg;
+
+	switch (pattern)
+	{
+	case 0:
+		pwm_breathe(2000);                     // 2 s breathing
+		break;
+	case 1:
+		pwm_blink(250, 250, 255);              // plain blink, now in hardware
+		break;
+	default:
+		pwm_fade(255, 0, 3000);                // fade out and stay off
+		break;
+	}
+
+	pattern = (pattern + 1U) % 3U;
 }
@@ -0,0 +1,185 @@
+/*
+ * PWM LED driver, DMA fed brightness sequences (see pwm.h)
+ */
+
+#include <math.h>
+#include "pwm.h"
+#include "regclr.h"
+
+#define MS_TO_STEPS(ms)   (((ms) * PWM_HZ) / 1000U)
+
+static uint32_t gamma_tab[256];        // Brightness -> CCR1
+static uint32_t seq[PWM_SEQ_MAX];      // CCR1 values, one per PWM period
+
+/*==========================================================*/
+
+static void gamma_init(void)
+{
+	for (uint32_t i = 0; i < 256U; i++)
+	{
+		float x = (float)i / 255.0f;
+
+		gamma_tab[i] = (uint32_t)((powf(x, PWM_GAMMA) * (float)(PWM_TOP + 1U)) + 0.5f);
+	}
+}
+
+static uint32_t timer_clock(void)
+{
+	uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+	uint32_t timclk;
+
+	SystemCoreClockUpdate();
+	timclk = SystemCoreClock >> APBPrescTable[ppre1];
+	if (APBPrescTable[ppre1] != 0U)
+	{
+		timclk *= 2U;                              // APB1 timers run at 2 x PCLK1
+	}
+	return timclk;
+}
+
+static void dma_stop(void)
+{
+	DMA1_Stream1->CR &= ~DMA_SxCR_EN;
+	while (DMA1_Stream1->CR & DMA_SxCR_EN){}
+}
+
+/*
+ * Stream the first n entries of seq[] into CCR1, one per update event
+ */
+static void dma_start(uint32_t n, uint8_t loop)
+{
+	dma_stream_clear(DMA1, 1);                     // Clear all Stream1 flags
+	DMA1_Stream1->M0AR = (uint32_t)seq;
+	DMA1_Stream1->NDTR = n;
+
+	// Channel3, memory -> peripheral, word to word, memory increment
+	DMA1_Stream1->CR = (3U << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_0 | DMA_SxCR_MSIZE_1 |
+	                   DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0;
+	if (loop)
+	{
+		DMA1_Stream1->CR |= DMA_SxCR_CIRC;
+	}
+
+	DMA1_Stream1->CR |= DMA_SxCR_EN;
+}
+
+/*==========================================================*/
+
+void pwm_init(void)
+{
+	gamma_init();
+
+	// PA5 -> AF1 (TIM2_CH1)
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN | RCC_AHB1ENR_DMA1EN;
+	(void)RCC->AHB1ENR;
+
+	GPIOA->MODER &= ~(3U << 10);
+	GPIOA->MODER |= (2U << 10);                    // Alternate function
+	GPIOA->OTYPER &= ~(1U << 5);                   // Push-pull
+	GPIOA->OSPEEDR &= ~(3U << 10);
+	GPIOA->PUPDR &= ~(3U << 10);
+	GPIOA->AFR[0] &= ~(0xFU << 20);
+	GPIOA->AFR[0] |= (1U << 20);                   // AF1
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+	(void)RCC->APB1ENR;
+
+	TIM2->CR1 &= ~TIM_CR1_CEN;
+
+	TIM2->PSC = (timer_clock() / (PWM_HZ * (PWM_TOP + 1U))) - 1U;
+	TIM2->ARR = PWM_TOP;
+	TIM2->CCR1 = 0;
+
+	// PWM mode 1 (110), CCR1 preload: a new duty starts with the next period only
+	TIM2->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M);
+	TIM2->CCMR1 |= (6U << TIM_CCMR1_OC1M_Pos) | TIM_CCMR1_OC1PE;
+	TIM2->CCER &= ~TIM_CCER_CC1P;                  // Active high
+	TIM2->CCER |= TIM_CCER_CC1E;
+	TIM2->CR1 |= TIM_CR1_ARPE;
+
+	TIM2->EGR = TIM_EGR_UG;                        // Load PSC, ARR, CCR1
+	TIM2->SR = 0;
+	TIM2->DIER |= TIM_DIER_UDE;                    // DMA request on update
+
+	DMA1_Stream1->PAR = (uint32_t)&TIM2->CCR1;
+
+	TIM2->CR1 |= TIM_CR1_CEN;
+}
+
+void pwm_set(uint8_t level)
+{
+	dma_stop();
+	TIM2->CCR1 = gamma_tab[level];
+}
+
+int pwm_breathe(uint32_t period_ms)
+{
+	uint32_t n = MS_TO_STEPS(period_ms);
+	uint32_t half = n / 2U;
+
+	if ((n > PWM_SEQ_MAX) || (half == 0U))
+	{
+		return -1;
+	}
+
+	dma_stop();                                    // seq[] is being rewritten
+
+	// Linear in perceived brightness, the gamma table makes it linear to the eye
+	for (uint32_t i = 0; i < half; i++)
+	{
+		uint32_t level = (i * 255U) / half;
+
+		seq[i] = gamma_tab[level];
+		seq[n - 1U - i] = gamma_tab[level];
+	}
+	if (n & 1U)
+	{
+		seq[half] = gamma_tab[255];
+	}
+
+	dma_start(n, 1);
+	return 0;
+}
+
+int pwm_blink(uint32_t on_ms, uint32_t off_ms, uint8_t level)
+{
+	uint32_t on = MS_TO_STEPS(on_ms);
+	uint32_t n = on + MS_TO_STEPS(off_ms);
+
+	if ((n > PWM_SEQ_MAX) || (n == 0U))
+	{
+		return -1;
+	}
+
+	dma_stop();                                    // seq[] is being rewritten
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		seq[i] = (i < on) ? gamma_tab[level] : 0U;
+	}
+
+	dma_start(n, 1);
+	return 0;
+}
+
+int pwm_fade(uint8_t from, uint8_t to, uint32_t time_ms)
+{
+	uint32_t n = MS_TO_STEPS(time_ms);
+
+	if ((n > PWM_SEQ_MAX) || (n == 0U))
+	{
+		return -1;
+	}
+
+	dma_stop();                                    // seq[] is being rewritten
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		int32_t level = (int32_t)from + ((((int32_t)to - (int32_t)from) * (int32_t)(i + 1U)) / (int32_t)n);
+
+		seq[i] = gamma_tab[level];
+	}
+
+	dma_start(n, 0);                               // CCR1 keeps the last value
+	return 0;
+}
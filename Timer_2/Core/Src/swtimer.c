@@ -0,0 +1,340 @@
+/*
+ * Software timers on one hardware compare channel (see swtimer.h)
+ */
+
+#include "swtimer.h"
+#include "regclr.h"
+
+#define WHEEL_MASK    (SWT_WHEEL_SIZE - 1U)
+#define MAP_WORDS     (SWT_WHEEL_SIZE / 32U)
+#define NO_SLOT       0xFFFFFFFFU
+
+// swtimer_t.active
+#define SWT_IDLE      0U
+#define SWT_QUEUED    1U
+#define SWT_REQUEUE   2U          // In the slot being fired, put back after the walk (expiry set)
+#define SWT_PENDING   3U          // In the slot being fired, not looked at yet
+#define SWT_DROPPED   4U          // In the slot being fired, stopped by a callback
+
+static swtimer_t *wheel[SWT_WHEEL_SIZE];         // Head of every slot list
+static uint32_t wheel_map[MAP_WORDS];            // Bit set = slot not empty
+static uint32_t wheel_time;                      // First tick not processed yet
+static uint8_t walking;                          // TIM5_IRQHandler is running callbacks
+
+/*
+ * Critical sections: start / stop from main must not interleave with the ISR
+ */
+static uint32_t swt_lock(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	return primask;
+}
+
+static void swt_unlock(uint32_t primask)
+{
+	__set_PRIMASK(primask);
+}
+
+/*==========================================================*/
+
+static void slot_insert(swtimer_t *t)
+{
+	uint32_t s = t->expiry & WHEEL_MASK;
+
+	t->prev = 0;
+	t->next = wheel[s];
+	if (wheel[s] != 0)
+	{
+		wheel[s]->prev = t;
+	}
+	wheel[s] = t;
+	wheel_map[s >> 5] |= (1U << (s & 31U));
+	t->active = SWT_QUEUED;
+}
+
+static void slot_remove(swtimer_t *t)
+{
+	uint32_t s = t->expiry & WHEEL_MASK;
+
+	if (t->prev != 0)
+	{
+		t->prev->next = t->next;
+	}
+	else
+	{
+		wheel[s] = t->next;
+	}
+	if (t->next != 0)
+	{
+		t->next->prev = t->prev;
+	}
+	if (wheel[s] == 0)
+	{
+		wheel_map[s >> 5] &= ~(1U << (s & 31U));
+	}
+	t->next = 0;
+	t->prev = 0;
+	t->active = SWT_IDLE;
+}
+
+// Taken by the slot walk (run_slot), not linked in the wheel
+static uint8_t in_walk(const swtimer_t *t)
+{
+	return (t->active == SWT_PENDING) || (t->active == SWT_REQUEUE) || (t->active == SWT_DROPPED);
+}
+
+/*
+ * Distance (0 .. SWT_WHEEL_SIZE-1) from slot 'from' to the next non-empty slot,
+ * NO_SLOT if the wheel is empty. One bit scan per 32 slots (RBIT + CLZ).
+ */
+static uint32_t next_slot_dist(uint32_t from)
+{
+	uint32_t w = from >> 5;
+	uint32_t bits = wheel_map[w] & (0xFFFFFFFFU << (from & 31U));
+
+	for (uint32_t i = 0; i <= MAP_WORDS; i++)
+	{
+		if (bits != 0U)
+		{
+			uint32_t slot = (w << 5) + (uint32_t)__builtin_ctz(bits);
+			return (slot - from) & WHEEL_MASK;
+		}
+		w = (w + 1U) % MAP_WORDS;
+		bits = wheel_map[w];
+	}
+	return NO_SLOT;
+}
+
+/*
+ * Program CCR1 to the next non-empty slot, or stop the compare interrupt.
+ * A slot may only hold timers of a later wheel revolution; that costs one
+ * extra wake-up per revolution, never a missed timer.
+ */
+static void arm_next(void)
+{
+	uint32_t d = next_slot_dist(wheel_time & WHEEL_MASK);
+
+	if (d == NO_SLOT)
+	{
+		TIM5->DIER &= ~TIM_DIER_CC1IE;
+		return;
+	}
+
+	uint32_t t = wheel_time + d;
+
+	TIM5->CCR1 = t;
+	TIM5->DIER |= TIM_DIER_CC1IE;
+
+	// Compare only fires on equality: if that tick is already here, run now
+	if ((int32_t)(TIM5->CNT - t) >= 0)
+	{
+		NVIC_SetPendingIRQ(TIM5_IRQn);
+	}
+}
+
+/*
+ * Fire every due timer of slot 'tick'.
+ * The whole slot list is detached first: callbacks may stop or start any
+ * timer, siblings in this slot included, without touching the list walked here.
+ * Such timers are only marked (SWT_DROPPED / SWT_REQUEUE) and settled by the walk.
+ * Periodic timers are re-queued after the walk so they cannot be
+ * visited twice when the period is a multiple of the wheel size.
+ */
+static void run_slot(uint32_t tick)
+{
+	uint32_t s = tick & WHEEL_MASK;
+	swtimer_t *t = wheel[s];
+	swtimer_t *again = 0;
+
+	wheel[s] = 0;
+	wheel_map[s >> 5] &= ~(1U << (s & 31U));
+	for (swtimer_t *p = t; p != 0; p = p->next)
+	{
+		p->active = SWT_PENDING;
+	}
+
+	while (t != 0)
+	{
+		swtimer_t *next = t->next;
+
+		if (t->active == SWT_PENDING)
+		{
+			if ((int32_t)(t->expiry - tick) <= 0)
+			{
+				if (t->period != 0U)
+				{
+					t->expiry += t->period;
+					t->active = SWT_REQUEUE;
+					t->next = again;
+					again = t;
+				}
+				else
+				{
+					t->active = SWT_IDLE;
+				}
+				t->cb(t->arg);
+			}
+			else
+			{
+				slot_insert(t);                        // Later revolution, back into the wheel
+			}
+		}
+		else if (t->active == SWT_REQUEUE)
+		{
+			t->next = again;                           // Started again by an earlier callback
+			again = t;
+		}
+		else
+		{
+			t->active = SWT_IDLE;                      // Stopped by an earlier callback
+		}
+		t = next;
+	}
+
+	while (again != 0)
+	{
+		swtimer_t *next = again->next;
+
+		if (again->active == SWT_REQUEUE)
+		{
+			slot_insert(again);
+		}
+		else
+		{
+			again->active = SWT_IDLE;
+		}
+		again = next;
+	}
+}
+
+/*==========================================================*/
+/*
+ * TIMER5 configuration
+ * - 1 ms per count for any APB1 clock, full 32-bit range
+ * - Channel 1 frozen output compare, used only for its interrupt
+ */
+
+void swt_init(void)
+{
+	uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+	uint32_t timclk;
+
+	SystemCoreClockUpdate();
+	timclk = SystemCoreClock >> APBPrescTable[ppre1];
+	if (APBPrescTable[ppre1] != 0U)
+	{
+		timclk *= 2U;                              // APB1 timers run at 2 x PCLK1
+	}
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+	(void)RCC->APB1ENR;
+
+	TIM5->CR1 &= ~TIM_CR1_CEN;
+
+	TIM5->PSC = (timclk / SWT_TICK_HZ) - 1U;
+	TIM5->ARR = 0xFFFFFFFFU;
+	TIM5->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_OC1M);
+	TIM5->EGR = TIM_EGR_UG;                        // Load PSC now
+	TIM5->SR = 0;
+	TIM5->CNT = 0;
+
+	for (uint32_t i = 0; i < SWT_WHEEL_SIZE; i++)
+	{
+		wheel[i] = 0;
+	}
+	for (uint32_t i = 0; i < MAP_WORDS; i++)
+	{
+		wheel_map[i] = 0;
+	}
+	wheel_time = 0;
+
+	NVIC_SetPriority(TIM5_IRQn, 2);
+	NVIC_EnableIRQ(TIM5_IRQn);
+
+	TIM5->CR1 |= TIM_CR1_CEN;
+}
+
+uint32_t swt_now(void)
+{
+	return TIM5->CNT;
+}
+
+void swt_start(swtimer_t *t, uint32_t delay_ms, uint32_t period_ms, swt_cb_t cb, void *arg)
+{
+	uint32_t primask = swt_lock();
+
+	if (t->active == SWT_QUEUED)
+	{
+		slot_remove(t);
+	}
+	else if (in_walk(t))
+	{
+		t->active = SWT_REQUEUE;
+	}
+
+	t->cb = cb;
+	t->arg = arg;
+	t->period = period_ms;
+	t->expiry = TIM5->CNT + ((delay_ms != 0U) ? delay_ms : 1U);
+
+	// Empty wheel: nothing between wheel_time and now needs a visit.
+	// Not during the walk: the ISR still advances wheel_time past the slot it fires.
+	if (!walking && (next_slot_dist(0) == NO_SLOT))
+	{
+		wheel_time = TIM5->CNT;
+	}
+
+	// Started from a callback while run_slot() holds it: queued with the new expiry there
+	if (t->active != SWT_REQUEUE)
+	{
+		slot_insert(t);
+		arm_next();
+	}
+
+	swt_unlock(primask);
+}
+
+void swt_stop(swtimer_t *t)
+{
+	uint32_t primask = swt_lock();
+
+	if (t->active == SWT_QUEUED)
+	{
+		slot_remove(t);
+		arm_next();
+	}
+	t->active = in_walk(t) ? SWT_DROPPED : SWT_IDLE;
+
+	swt_unlock(primask);
+}
+
+/*==========================================================*/
+
+void TIM5_IRQHandler(void)
+{
+	tim_sr_clear(TIM5, TIM_SR_CC1IF);              // rc_w0: clears only CC1IF
+
+	uint32_t now = TIM5->CNT;
+
+	walking = 1;
+
+	// Visit the non-empty slots from wheel_time up to now
+	while ((int32_t)(now - wheel_time) >= 0)
+	{
+		uint32_t d = next_slot_dist(wheel_time & WHEEL_MASK);
+
+		if ((d == NO_SLOT) || ((int32_t)((wheel_time + d) - now) > 0))
+		{
+			wheel_time = now + 1U;
+			break;
+		}
+
+		run_slot(wheel_time + d);
+		wheel_time += d + 1U;
+		now = TIM5->CNT;                           // Callbacks take time too
+	}
+
+	walking = 0;
+	arm_next();
+}
@@ -0,0 +1,39 @@
+/*
+ * Cooperative run-to-completion scheduler
+ *
+ * - Up to SCHED_MAX_TASKS tasks, one per priority (higher number runs first)
+ * - A task is a function called with the events posted to it since its last run;
+ *   it must return (no blocking loops), the next ready task runs afterwards
+ * - Events can be posted from main or from any ISR (sched_post)
+ * - Every task owns one timer (one-shot or periodic) serviced from SysTick,
+ *   expiry posts SCHED_EVT_TIMER
+ * - No ready task: the core sleeps in WFI until the next interrupt
+ *
+ * SysTick_Handler must call sched_tick() (stm32f4xx_it.c, USER CODE SysTick_IRQn)
+ */
+
+#ifndef INC_SCHED_H_
+#define INC_SCHED_H_
+
+#include "stm32f4xx.h"
+
+#define SCHED_MAX_TASKS    8U          // Priorities 0 .. SCHED_MAX_TASKS-1
+#define SCHED_TICK_HZ      1000U       // SysTick rate, 1 tick = 1 ms
+
+#define SCHED_EVT_TIMER    (1U << 0)   // Task timer expired
+#define SCHED_EVT_USER(n)  (1U << (n)) // Application events, n = 1 .. 31
+
+typedef void (*sched_task_t)(uint32_t events);
+
+void sched_init(void);
+int sched_add(uint32_t prio, sched_task_t task);      // 0 on success, -1 if the priority is taken
+
+void sched_post(uint32_t prio, uint32_t events);      // Safe from ISRs
+void sched_timer(uint32_t prio, uint32_t delay_ms, uint32_t period_ms);  // period 0 = one-shot
+void sched_timer_stop(uint32_t prio);
+uint32_t sched_now(void);                             // Ticks since sched_init()
+
+void sched_tick(void);                                // From SysTick_Handler only
+void sched_run(void);                                 // Never returns
+
+#endif /* INC_SCHED_H_ */
@@ -2,22 +2,36 @@
  * Sending Character Using UART TX
  */
 #include"stm32f4xx.h"
+#include"sched.h"
 
 #define BAUDRATE     115200U
 #define CLOCK_FREQ   16000000U  //MCU Clock Speed(16MHz)
 
+#define TX_PRIO      1U
+#define TX_PERIOD_MS 10U        //Spacing between characters
+
 
 static void uart_config(void);
 static uint32_t Baudrate_config(uint32_t Clk_freq,uint32_t Baudrate);
 static void Uart_tx(char ch);
+static void tx_task(uint32_t events);
 
 int main(void)
 {
 	uart_config();
-	while(1)
+
+	sched_init();
+	sched_add(TX_PRIO, tx_task);
+	sched_timer(TX_PRIO, TX_PERIOD_MS, TX_PERIOD_MS);
+
+	sched_run();               //CPU sleeps (WFI) between characters
+}
+
+static void tx_task(uint32_t events)
+{
+	if(events & SCHED_EVT_TIMER)
 	{
-		Uart_tx('U');
-		for(volatile uint16_t i=0;i<50000;i++);
+		Uart_tx('U');          //TXE is long set after 10 ms, no wait
 	}
 }
 
@@ -0,0 +1,36 @@
+/*
+ * Input capture edge timestamps on TIMER2 channel 1
+ *
+ * - PA0 (TIM2_CH1, AF1) captures BOTH edges in hardware
+ * - Input digital filter (ICF) removes short glitches before the capture
+ * - Every capture (CCR1) is copied by DMA into a circular buffer,
+ *   the CPU only reads the buffer when it wants to
+ * - Every capture also raises the TIM2 interrupt, so the main loop can
+ *   sleep (WFI) while cap_pending() is 0
+ * - cap_wake_at() arms TIM2 channel 2 as a one-shot wake-up timer
+ * - Timestamps are in timestamp.h ticks (TIM2 is shared with ts_now()),
+ *   the low 32 bits of the 64-bit clock, ts_extend() gives the full time
+ *
+ * Wiring: Nucleo user button B1 is on PC13, which has no timer channel.
+ *         Connect PC13 to PA0 with a jumper wire.
+ */
+
+#ifndef INC_CAPTURE_H_
+#define INC_CAPTURE_H_
+
+#include "stm32f4xx.h"
+
+#define CAP_BUF_LEN   32U         // Captures kept by DMA, read them before 32 more edges arrive
+
+typedef struct
+{
+	uint32_t ts;                  // Timer count latched by the hardware at the edge
+	uint8_t  level;               // Pin level after the edge (0 = falling, 1 = rising)
+} cap_event_t;
+
+void cap_init(void);              // Call after ts_init()
+uint8_t cap_read(cap_event_t *ev);   // 1 = new event returned, 0 = nothing new
+uint8_t cap_pending(void);        // 1 = cap_read() has an event waiting
+void cap_wake_at(uint32_t ts);    // TIM2 interrupt once ts_now() reaches ts
+
+#endif /* INC_CAPTURE_H_ */
@@ -0,0 +1,39 @@
+/*
+ * Delays and timeouts independent of the clock speed and -O level
+ *
+ * - delay_us(): busy wait on the DWT cycle counter, cycle exact
+ * - delay_ms(): sleeps in WFI, woken by the 1 ms SysTick
+ * - delay_wait(): polls a register bit with a timeout, for peripheral
+ *   flag loops such as while(!(USART2->SR & USART_SR_TXE))
+ * - deadline_t: start now, check later, for hand written polling loops
+ *
+ * SysTick_Handler must call delay_tick() (stm32f4xx_it.c, USER CODE SysTick_IRQn)
+ * delay_init() must run again after a change of SystemCoreClock.
+ */
+
+#ifndef INC_DELAY_H_
+#define INC_DELAY_H_
+
+#include "stm32f4xx.h"
+
+typedef struct
+{
+	uint32_t start;                // DWT->CYCCNT at deadline_us()
+	uint32_t cycles;
+} deadline_t;
+
+void delay_init(void);
+void delay_tick(void);             // From SysTick_Handler only
+
+void delay_us(uint32_t us);        // Busy, us <= delay_us_max()
+void delay_ms(uint32_t ms);        // Sleeping, at least ms
+uint32_t delay_us_max(void);       // 2^32 cycles in us (~268 s at 16 MHz)
+uint32_t delay_millis(void);       // 1 ms ticks since delay_init()
+
+void deadline_us(deadline_t *d, uint32_t us);
+uint8_t deadline_expired(const deadline_t *d);
+
+// 0 when (*reg & mask) == value within 'us', -1 on timeout
+int delay_wait(volatile uint32_t *reg, uint32_t mask, uint32_t value, uint32_t us);
+
+#endif /* INC_DELAY_H_ */
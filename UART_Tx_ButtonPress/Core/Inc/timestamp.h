@@ -0,0 +1,44 @@
+/*
+ * 64-bit timestamp service on TIMER2 + TIMER5 (master / slave chain)
+ *
+ * - TIM2 counts the timer clock directly (PSC = 0), 1 tick = 1 / ts_hz()
+ *   (62.5 ns at the default 16 MHz)
+ * - TIM2 update (wrap) -> TRGO -> ITR0 -> TIM5 counts one: TIM5:TIM2 is a
+ *   64-bit hardware counter, no overflow interrupt, no software extension
+ * - ts_now64(): lock-free consistent read (hi-lo-hi), callable from any ISR
+ * - ts_now(): low 32 bits only, a single register read; differences of it are
+ *   correct across a wrap for intervals below 2^32 ticks (~268 s at 16 MHz)
+ */
+
+#ifndef INC_TIMESTAMP_H_
+#define INC_TIMESTAMP_H_
+
+#include "stm32f4xx.h"
+
+void ts_init(void);               // Configure and start TIM5 (high) and TIM2 (low)
+uint32_t ts_timer_clock(void);    // APB1 timer clock, read from RCC
+uint32_t ts_hz(void);             // Tick rate set by ts_init()
+uint64_t ts_now64(void);          // Full 64-bit count, never wraps in practice
+
+// Low word of a recent 64-bit time (a TIM2 capture, ts_now()) -> 64-bit time.
+// 'lo' must be less than 2^32 ticks old.
+uint64_t ts_extend(uint32_t lo);
+
+// Conversions
+uint64_t ts_to_ns(uint64_t ticks);
+uint64_t ts_to_us(uint64_t ticks);
+uint32_t ts_us_to_ticks(uint32_t us);
+
+// Current low 32 bits, a single register read
+static inline uint32_t ts_now(void)
+{
+	return TIM2->CNT;
+}
+
+// Ticks since 'start' (32-bit)
+static inline uint32_t ts_elapsed(uint32_t start)
+{
+	return TIM2->CNT - start;
+}
+
+#endif /* INC_TIMESTAMP_H_ */
@@ -0,0 +1,176 @@
+/*
+ * Input capture edge timestamps (see capture.h)
+ *
+ * DMA1 Stream5 Channel3 -> TIM2_CH1
+ * TIM2 CC1 / CC2 interrupts only wake the CPU, they move no data
+ */
+
+#include "capture.h"
+#include "regclr.h"
+
+static volatile uint32_t cap_buf[CAP_BUF_LEN];   // Filled by DMA, never by the CPU
+static uint32_t cap_rd;                          // Next index to read
+static uint8_t cap_level;                        // Pin level after the last event read
+
+/*==========================================================*/
+/*
+ * PA0 as TIM2_CH1 input (AF1) with pull-up
+ */
+
+static void cap_gpio_config(void)
+{
+	RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;
+	(void)RCC->AHB1ENR;
+
+	GPIOA->MODER &= ~(3U << 0);
+	GPIOA->MODER |=  (2U << 0);
+
+	GPIOA->AFR[0] &= ~(0xFU << 0);
+	GPIOA->AFR[0] |=  (1U << 0);
+
+	GPIOA->PUPDR &= ~(3U << 0);
+	GPIOA->PUPDR |=  (1U << 0);
+}
+
+/*==========================================================*/
+/*
+ * DMA: CCR1 -> cap_buf[], 32-bit, circular
+ */
+
+static void cap_dma_config(void)
+{
+	RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+	(void)RCC->AHB1ENR;
+
+	DMA1_Stream5->CR &= ~DMA_SxCR_EN;
+	while (DMA1_Stream5->CR & DMA_SxCR_EN) {}
+
+	dma_stream_clear(DMA1, 5);                   // Clear all Stream5 flags (write 1 to clear)
+
+	DMA1_Stream5->PAR  = (uint32_t)&TIM2->CCR1;
+	DMA1_Stream5->M0AR = (uint32_t)cap_buf;
+	DMA1_Stream5->NDTR = CAP_BUF_LEN;
+
+	// Channel3, peripheral -> memory, 32-bit both sides, memory increment, circular
+	DMA1_Stream5->CR = (3U << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL_1 |
+	                   DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_CIRC;
+
+	DMA1_Stream5->CR |= DMA_SxCR_EN;
+}
+
+/*==========================================================*/
+/*
+ * TIM2 channel 1 input capture
+ * - CC1S = 01   : IC1 mapped on TI1
+ * - ICF  = 1111 : fSAMPLING = fDTS/32, N = 8
+ *                 with CKD = 10 (tDTS = 4 x tCK_INT) a level must be stable
+ *                 for 8 x 128 timer clocks (64 us at 16 MHz) to be captured
+ * - CC1P = CC1NP = 1 : capture on both edges
+ * - CC1DE       : every capture requests a DMA transfer
+ * - CC1IE       : and an interrupt, so a WFI in the main loop ends on every edge
+ * - CC2         : output compare, frozen (no pin), used by cap_wake_at()
+ */
+
+void cap_init(void)
+{
+	cap_gpio_config();
+	cap_dma_config();
+
+	TIM2->CCER &= ~TIM_CCER_CC1E;                  // Channel off while it is configured
+
+	TIM2->CR1 &= ~TIM_CR1_CKD;
+	TIM2->CR1 |=  TIM_CR1_CKD_1;
+
+	TIM2->CCMR1 &= ~(TIM_CCMR1_CC1S | TIM_CCMR1_IC1F | TIM_CCMR1_IC1PSC);
+	TIM2->CCMR1 |=  (TIM_CCMR1_CC1S_0 | TIM_CCMR1_IC1F);
+
+	TIM2->CCER |= (TIM_CCER_CC1P | TIM_CCER_CC1NP);
+
+	TIM2->CCMR1 &= ~(TIM_CCMR1_CC2S | TIM_CCMR1_OC2M);
+
+	TIM2->DIER &= ~TIM_DIER_CC2IE;
+	tim_sr_clear(TIM2, TIM_SR_CC1IF | TIM_SR_CC2IF);
+	TIM2->DIER |= (TIM_DIER_CC1DE | TIM_DIER_CC1IE);
+
+	NVIC_SetPriority(TIM2_IRQn, 15);
+	NVIC_EnableIRQ(TIM2_IRQn);
+
+	cap_rd = 0;
+	cap_level = (GPIOA->IDR >> 0) & 1U;            // Level before the first edge
+
+	TIM2->CCER |= TIM_CCER_CC1E;
+}
+
+/*==========================================================*/
+/*
+ * Next captured edge
+ * - DMA write position comes from NDTR, nothing is shared with an ISR
+ * - The filter guarantees every capture is a real level change,
+ *   so the level simply alternates from the initial one
+ */
+
+static uint32_t cap_wr(void)
+{
+	uint32_t wr = CAP_BUF_LEN - DMA1_Stream5->NDTR;
+
+	return (wr == CAP_BUF_LEN) ? 0 : wr;
+}
+
+uint8_t cap_pending(void)
+{
+	return cap_wr() != cap_rd;
+}
+
+uint8_t cap_read(cap_event_t *ev)
+{
+	if (cap_wr() == cap_rd)
+	{
+		return 0;
+	}
+
+	ev->ts = cap_buf[cap_rd];
+	cap_level ^= 1U;
+	ev->level = cap_level;
+
+	cap_rd = (cap_rd + 1U) % CAP_BUF_LEN;
+
+	return 1;
+}
+
+/*==========================================================*/
+/*
+ * One-shot wake-up at a timestamp (low 32 bits, ts_now() ticks)
+ * - CCR2 matches TIM2->CNT once, the interrupt disables itself
+ * - A time already reached pends the interrupt directly,
+ *   otherwise the compare would only match a full wrap later
+ */
+
+void cap_wake_at(uint32_t ts)
+{
+	TIM2->DIER &= ~TIM_DIER_CC2IE;
+	TIM2->CCR2 = ts;
+	tim_sr_clear(TIM2, TIM_SR_CC2IF);
+	TIM2->DIER |= TIM_DIER_CC2IE;
+
+	if ((int32_t)(TIM2->CNT - ts) >= 0)
+	{
+		NVIC_SetPendingIRQ(TIM2_IRQn);
+	}
+}
+
+/*==========================================================*/
+/*
+ * TIM2 interrupt: wake-up only
+ * - CC1IF may already be cleared by the DMA reading CCR1, the NVIC
+ *   pending bit still ends the WFI
+ */
+
+void TIM2_IRQHandler(void)
+{
+	if (TIM2->SR & TIM_SR_CC2IF)
+	{
+		TIM2->DIER &= ~TIM_DIER_CC2IE;
+	}
+
+	tim_sr_clear(TIM2, TIM_SR_CC1IF | TIM_SR_CC2IF);
+}
@@ -0,0 +1,93 @@
+/*
+ * Delays and timeouts (see delay.h)
+ */
+
+#include "delay.h"
+
+static uint32_t cyc_per_us;
+static volatile uint32_t ticks;
+
+/*==========================================================*/
+/*
+ * DWT cycle counter: counts core clocks whatever the optimisation level
+ * SysTick: 1 ms wake-up for the sleeping delays
+ */
+
+void delay_init(void)
+{
+	SystemCoreClockUpdate();
+	cyc_per_us = SystemCoreClock / 1000000U;
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	ticks = 0;
+	SysTick_Config(SystemCoreClock / 1000U);
+	NVIC_SetPriority(SysTick_IRQn, 15);
+}
+
+void delay_tick(void)
+{
+	ticks++;
+}
+
+uint32_t delay_millis(void)
+{
+	return ticks;
+}
+
+uint32_t delay_us_max(void)
+{
+	return 0xFFFFFFFFU / cyc_per_us;
+}
+
+/*==========================================================*/
+
+void delay_us(uint32_t us)
+{
+	uint32_t start = DWT->CYCCNT;
+	uint32_t n = us * cyc_per_us;
+
+	while ((DWT->CYCCNT - start) < n){}
+}
+
+void delay_ms(uint32_t ms)
+{
+	uint32_t start = ticks;
+
+	// The first tick may come at once: ms + 1 ticks give at least ms
+	while ((ticks - start) <= ms)
+	{
+		__WFI();
+	}
+}
+
+/*==========================================================*/
+
+void deadline_us(deadline_t *d, uint32_t us)
+{
+	d->start = DWT->CYCCNT;
+	d->cycles = us * cyc_per_us;
+}
+
+uint8_t deadline_expired(const deadline_t *d)
+{
+	return ((DWT->CYCCNT - d->start) >= d->cycles);
+}
+
+int delay_wait(volatile uint32_t *reg, uint32_t mask, uint32_t value, uint32_t us)
+{
+	deadline_t d;
+
+	deadline_us(&d, us);
+	while ((*reg & mask) != value)
+	{
+		if (deadline_expired(&d))
+		{
+			// The flag may have come while the deadline was checked
+			return ((*reg & mask) == value) ? 0 : -1;
+		}
+	}
+	return 0;
+}
@@ -3,38 +3,32 @@
  *
  * Concept:
  * - Measure how long a button is pressed
- * - Use TIMER2 to count time
+ * - Use TIMER2 + TIMER5 as a 64-bit timer clock timestamp (timestamp.c)
+ * - Both button edges are captured in hardware by TIM2 CH1 (capture.c)
+ * - The CPU sleeps (WFI) until an edge or the release timeout wakes it
  * - Use UART (USART2) to print the duration
- * - Button press detected using edge detection
+ *
+ * Wiring: PC13 (user button) -> PA0 (TIM2_CH1)
  */
 
 #include"stm32f4xx.h"
 #include<stdio.h>     // Required for printf() and sprintf()
+#include"timestamp.h"
+#include"capture.h"
+#include"delay.h"
 
 #define HIGH 1
 #define LOW  0
 #define BAUDRATE     115200U
 #define CLOCK_FREQ   16000000U  // MCU Clock Speed (16 MHz)
-
-/*
- * Global variable to count timer overflows.
- *
- * IMPORTANT:
- * - This variable is modified inside an ISR (TIM2_IRQHandler)
- * - Therefore it MUST be declared as volatile
- * - static is NOT used because ISR and main must share this variable
- */
-
-volatile uint32_t num_of_over_flows;
+#define BOUNCE_US    20000U     // Edges closer than this belong to the same press/release
+#define TX_TIMEOUT_US 1000U     // > one character at 115200 baud (~87 us)
 
 /* Function declarations */
 static void uart_config(void);
 static uint32_t Baudrate_config(uint32_t Clk_freq,uint32_t Baudrate);
 static void Uart_tx(char ch);
 static void gpio_config(void);
-static void timer_config(void);
-static float cal_fun(void);
-static void nvic_config(void);
 
 /*==========================================================*/
 /*
@@ -55,56 +49,83 @@ int __io_putchar(int ch){
 int main(void)
 {
     gpio_config();             // Configure button GPIO (PC13)
-	timer_config();            // Configure TIMER2
+	ts_init();                 // Start TIMER2 + TIMER5 timestamps (timer clock)
+	cap_init();                // Capture both edges on PA0 into the DMA buffer
 	uart_config();             // Configure USART2 for TX
+	delay_init();              // DWT cycle counter for the TX timeout
 
 	char Duration[20];         // Buffer to store formatted time string
-	uint8_t curr_state;        // Current button state
-    uint8_t prev_state = HIGH; // Assume button initially released (pull-up)
+	cap_event_t ev;            // One captured edge
+	uint64_t t_press = 0;      // Timestamp of the first falling edge of a press
+	uint64_t t_release = 0;    // Timestamp of the last rising edge
+	uint32_t bounce = ts_us_to_ticks(BOUNCE_US);
+	uint8_t pressed = 0;
+	uint8_t release_pending = 0;
 
 	// Infinite loop
     while (1)
     {
-       curr_state = (((GPIOC->IDR) >> 13) & 1);                // Read PC13 input value (button state)
-
-       for(volatile uint32_t num = 0; num < 20000; num++);     // Simple software debounce delay
-
-       /*
-        * FALLING EDGE detection
-        * HIGH -> LOW means button is pressed
-        */
-       if ((prev_state == HIGH) && (curr_state == LOW))
+       // Handle every edge the hardware captured since the last pass
+       while (cap_read(&ev))
        {
-              TIM2->SR &= ~TIM_SR_UIF;     // Clear update interrupt flag
-              TIM2->CNT = 0;              // Reset timer counter
-              TIM2->CR1 |= TIM_CR1_CEN;   // Start the timer
+           /*
+            * FALLING EDGE
+            * HIGH -> LOW means button is pressed (or bounced back down)
+            */
+           if (ev.level == LOW)
+           {
+               if (!pressed)
+               {
+                   pressed = 1;
+                   t_press = ts_extend(ev.ts);     // Capture is the low 32 bits
+               }
+               release_pending = 0;
+           }
+
+           /*
+            * RISING EDGE
+            * LOW -> HIGH, only a release once no falling edge follows within BOUNCE_US
+            */
+           else
+           {
+               t_release = ts_extend(ev.ts);
+               release_pending = 1;
+               cap_wake_at(ev.ts + bounce + 1U);   // First tick the check below passes
+           }
        }
 
-       /*
-        * RISING EDGE detection
-        * LOW -> HIGH means button is released
-        */
-       else if ((prev_state == LOW) && (curr_state == HIGH))
+       if (pressed && release_pending && ((ts_now64() - t_release) > bounce))
        {
-              TIM2->CR1 &= ~TIM_CR1_CEN;  // Stop the timer
+              pressed = 0;
+              release_pending = 0;
 
-              // Calculate pressed duration in seconds
-              float sec = cal_fun();
+              // Both timestamps were latched by the hardware at the edges
+              uint64_t us = ts_to_us(t_release - t_press);
 
               /*
                * sprintf():
-               * - Converts float value into formatted string
+               * - Converts the value into formatted string
                * - Stores result into character array
-               * - "%.2f" means print float with 2 decimal places
+               * - seconds.microseconds, integer math keeps full resolution
                */
-              sprintf(Duration, "%.2f\r\n", sec);
+              sprintf(Duration, "%lu.%06lu\r\n", (uint32_t)(us / 1000000U), (uint32_t)(us % 1000000U));
 
               // Print the duration through UART
               printf("%s", Duration);
        }
 
-        // Store current state as previous state, Used for next loop iteration to detect edges
-       prev_state = curr_state;
+       /*
+        * Sleep until the next capture or the release compare
+        * - PRIMASK keeps an interrupt between the check and WFI pending,
+        *   WFI still returns on it
+        * - A wake-up with nothing to do (a stale compare) just loops once
+        */
+       __disable_irq();
+       if (!cap_pending())
+       {
+           __WFI();
+       }
+       __enable_irq();
     }
 }
 
@@ -184,112 +205,18 @@ static uint32_t Baudrate_config(uint32_t Clk_freq,uint32_t Baudrate)
 /*==========================================================*/
 /*
  * UART transmit function
- * - Polls TXE flag
+ * - Polls TXE flag, gives up after TX_TIMEOUT_US (USART not clocked / stuck)
  * - Sends one character
  */
 
 static void Uart_tx(char ch)
 {
 	// Wait until transmit data register is empty
-	while(!(USART2->SR & USART_SR_TXE)) {}
+	if (delay_wait(&USART2->SR, USART_SR_TXE, USART_SR_TXE, TX_TIMEOUT_US) != 0)
+	{
+		return;                // Character dropped, the caller never hangs
+	}
 
 	// Write data to DR to transmit
 	USART2->DR = ch;
 }
-
-/*==========================================================*/
-/*
- * TIMER2 configuration
- * - Used to measure button press duration
- * - Prescaler creates 1ms tick
- * - Overflow interrupt enabled
- */
-
-static void timer_config(void)
-{
-	// Enable clock for TIMER2
-	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
-	(void)RCC->APB1ENR;
-
-	// Disable timer before configuration
-	TIM2->CR1 &= ~TIM_CR1_CEN;
-
-	/*
-	 * Prescaler:
-	 * 16 MHz / 16000 = 1000 Hz
-	 * => Timer increments every 1 ms
-	 */
-	TIM2->PSC = 15999;
-
-
-	TIM2->ARR = 100000;                // Auto-reload value (overflow after 100000 ms)
-
-
-	TIM2->DIER |= TIM_DIER_UIE;         // Enable update interrupt
-
-
-	TIM2->SR &= ~TIM_SR_UIF;            // Clear update interrupt flag
-
-	// Reset counter
-	TIM2->CNT = 0;
-
-	// Configure NVIC for TIM2 interrupt
-	nvic_config();
-}
-
-/*==========================================================*/
-/*
- * NVIC configuration for TIMER2 interrupt
- * IRQ number for TIM2 = 28
- */
-
-static void nvic_config(void)
-{
-	// Enable TIM2 interrupt in NVIC
-	NVIC->ISER[0] |= (1U << 28);
-
-	// Set priority for TIM2 interrupt
-	NVIC->IP[28] &= ~(0xFU << 4);
-	NVIC->IP[28] |=  (1U << 4);
-}
-
-/*==========================================================*/
-/*
- * Function to calculate time duration
- * Uses:
- * - Timer counter value
- * - Number of overflows
- */
-
-static float cal_fun(void)
-{
-	uint32_t count = TIM2->CNT;
-
-	/*
-	 * Total time in milliseconds:
-	 * (overflow_count * ARR) + current_counter
-	 * Divide by 1000 to convert to seconds
-	 */
-	float sec = (((num_of_over_flows * 100000) + count) / 1000.0f);
-
-
-	TIM2->CNT = 0;               // Reset timer and overflow count
-	num_of_over_flows = 0;
-
-	return sec;
-}
-
-/*==========================================================*/
-/*
- * TIMER2 Interrupt Service Routine
- * -Triggered on timer overflow
- * -Increments overflow counter
- */
-
-void TIM2_IRQHandler(void)
-{
-
-	TIM2->SR &= ~TIM_SR_UIF;      // Clear update interrupt flag
-
-	num_of_over_flows++;          // Increment overflow count
-}
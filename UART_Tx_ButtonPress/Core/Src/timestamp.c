@@ -0,0 +1,150 @@
+/*
+ * 64-bit timestamp service on TIMER2 + TIMER5 (see timestamp.h)
+ */
+
+#include "timestamp.h"
+#include "regclr.h"
+
+/*
+ * TIM5 is clocked from the TIM2 TRGO through the slave resynchronisation,
+ * it increments a few timer clocks after TIM2 has wrapped. A low word
+ * below this window may still be paired with the old high word.
+ */
+#define TS_CARRY_WINDOW   8U
+
+static uint32_t ts_rate;
+
+/*==========================================================*/
+/*
+ * TIM2 input clock
+ * - APB1 prescaler = 1 -> timer clock = PCLK1
+ * - APB1 prescaler > 1 -> timer clock = 2 x PCLK1
+ */
+
+uint32_t ts_timer_clock(void)
+{
+	uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+
+	SystemCoreClockUpdate();
+
+	if (APBPrescTable[ppre1] == 0U)
+	{
+		return SystemCoreClock;
+	}
+	return (SystemCoreClock >> APBPrescTable[ppre1]) * 2U;
+}
+
+uint32_t ts_hz(void)
+{
+	return ts_rate;
+}
+
+/*==========================================================*/
+/*
+ * TIMER2 (low word, master) + TIMER5 (high word, slave) configuration
+ * - TIM2: PSC = 0, full 32-bit range, MMS = 010 (update event -> TRGO)
+ * - TIM5: SMS = 111 (external clock mode 1), TS = 000 (ITR0 = TIM2 TRGO),
+ *         PSC = 0, full 32-bit range -> counts TIM2 wraps
+ * - No interrupt on either timer
+ */
+
+void ts_init(void)
+{
+	// Enable clock for TIMER2 and TIMER5
+	RCC->APB1ENR |= RCC_APB1ENR_TIM2EN | RCC_APB1ENR_TIM5EN;
+	(void)RCC->APB1ENR;
+
+	// Disable both timers before configuration
+	TIM2->CR1 &= ~TIM_CR1_CEN;
+	TIM5->CR1 &= ~TIM_CR1_CEN;
+
+	ts_rate = ts_timer_clock();
+
+	TIM2->PSC = 0;
+	TIM2->ARR = 0xFFFFFFFFU;                 // Free running over the whole 32-bit range
+	TIM2->DIER &= ~TIM_DIER_UIE;             // No overflow interrupt needed
+	TIM2->CR2 &= ~TIM_CR2_MMS;               // Keep UG below off the TRGO
+
+	TIM5->PSC = 0;
+	TIM5->ARR = 0xFFFFFFFFU;
+	TIM5->DIER = 0;
+
+	/*
+	 * PSC is buffered, it is only loaded on an update event.
+	 * UG forces the update so the first period already uses it.
+	 */
+	TIM2->EGR = TIM_EGR_UG;
+	TIM5->EGR = TIM_EGR_UG;
+	tim_sr_clear(TIM2, TIM_SR_UIF);         // rc_w0: writing 0 clears only UIF
+	tim_sr_clear(TIM5, TIM_SR_UIF);
+
+	// Chain: TIM2 update -> TRGO -> TIM5 ITR0, TIM5 counts on every trigger
+	TIM2->CR2 |= (2U << TIM_CR2_MMS_Pos);
+	TIM5->SMCR &= ~(TIM_SMCR_SMS | TIM_SMCR_TS | TIM_SMCR_ECE);
+	TIM5->SMCR |= (7U << TIM_SMCR_SMS_Pos);  // TS = 000 (ITR0)
+
+	TIM2->CNT = 0;
+	TIM5->CNT = 0;
+
+	TIM5->CR1 |= TIM_CR1_CEN;                // Slave first, it must be enabled to count triggers
+	TIM2->CR1 |= TIM_CR1_CEN;                // Start, never stopped or reset again
+}
+
+/*==========================================================*/
+/*
+ * 64-bit read, hi-lo-hi
+ * - High word changed between the two reads -> a wrap happened, read again
+ * - Low word inside the carry window -> the high word may lag, read again
+ *   (costs at most TS_CARRY_WINDOW ticks, once every 2^32 ticks)
+ * No interrupt masking, an ISR preempting this just causes a retry.
+ */
+
+uint64_t ts_now64(void)
+{
+	uint32_t hi, lo;
+
+	while (1)
+	{
+		hi = TIM5->CNT;
+		lo = TIM2->CNT;
+		if ((lo >= TS_CARRY_WINDOW) && (TIM5->CNT == hi))
+		{
+			return ((uint64_t)hi << 32) | lo;
+		}
+	}
+}
+
+uint64_t ts_extend(uint32_t lo)
+{
+	uint64_t now = ts_now64();
+
+	// Age in ticks fits 32 bits, unsigned difference handles the wrap
+	return now - (uint32_t)((uint32_t)now - lo);
+}
+
+/*==========================================================*/
+/*
+ * Conversions
+ * Split into seconds and remainder so ticks * 1e9 never overflows 64 bits.
+ */
+
+uint64_t ts_to_ns(uint64_t ticks)
+{
+	uint64_t s = ticks / ts_rate;
+	uint64_t r = ticks % ts_rate;
+
+	return (s * 1000000000ULL) + ((r * 1000000000ULL) / ts_rate);
+}
+
+uint64_t ts_to_us(uint64_t ticks)
+{
+	uint64_t s = ticks / ts_rate;
+	uint64_t r = ticks % ts_rate;
+
+	return (s * 1000000ULL) + ((r * 1000000ULL) / ts_rate);
+}
+
+uint32_t ts_us_to_ticks(uint32_t us)
+{
+	return (uint32_t)(((uint64_t)us * ts_rate) / 1000000U);
+}
@@ -0,0 +1,76 @@
+/*
+ * Parallel bus on one GPIO port (displays with 8080 style interface, parallel ADCs)
+ *
+ * - Data on 'width' consecutive pins starting at 'shift'
+ * - A value is written with one BSRR store: reset bits of the whole bus in the
+ *   high half, set bits of the value in the low half (set wins over reset), so
+ *   every data pin changes on the same AHB write, no glitch through 0
+ * - Optional WR and RD strobes on the same port, active low: data and WR low
+ *   go out in the same store, WR rising edge latches
+ * - Read path: bus switched to input, RD low, access time, IDR
+ * - DMA burst: TIM8 update -> DMA2 Stream1 Channel7 -> BSRR, two words per
+ *   value (data + WR low, WR high), no CPU during the burst
+ */
+
+#ifndef INC_PBUS_H_
+#define INC_PBUS_H_
+
+#include "stm32f4xx.h"
+
+#define PBUS_NO_PIN       0xFFU
+#define PBUS_MAX_HZ_DIV   8U       // DMA word rate limit = TIM8 clock / PBUS_MAX_HZ_DIV
+
+typedef struct
+{
+	uint32_t setup_ns;             // Data valid before the WR rising edge (WR low time too)
+	uint32_t pulse_ns;             // Minimum WR / RD low time
+	uint32_t access_ns;            // RD low -> data valid on the pins
+} pbus_timing_t;
+
+typedef struct
+{
+	GPIO_TypeDef *port;
+	uint32_t mask;                 // Data pins
+	uint32_t clr;                  // mask << 16, reset half of every data word
+	uint32_t shift;
+	uint32_t width;
+	uint32_t wr;                   // Strobe pin masks, 0 = not used
+	uint32_t rd;
+	uint32_t wr_cyc;               // Core clocks WR stays low
+	uint32_t rd_cyc;               // Core clocks from RD low to the IDR read
+	uint32_t mode_m2;              // MODER bits of the data pins
+	uint32_t mode_out;             // ... as outputs
+	uint8_t in;                    // 1 = bus is input
+} pbus_t;
+
+// Returns 0, or -1 for a bad pin range
+int pbus_init(pbus_t *b, GPIO_TypeDef *port, uint32_t shift, uint32_t width,
+              uint32_t wr_pin, uint32_t rd_pin, const pbus_timing_t *t);
+
+// BSRR word that puts 'v' on the bus, strobes untouched
+static inline uint32_t pbus_word(const pbus_t *b, uint32_t v)
+{
+	return b->clr | ((v << b->shift) & b->mask);
+}
+
+// Bus pins only, no strobe (latch driven elsewhere)
+static inline void pbus_put(const pbus_t *b, uint32_t v)
+{
+	b->port->BSRR = pbus_word(b, v);
+}
+
+void pbus_output(pbus_t *b);
+void pbus_input(pbus_t *b);
+
+void pbus_write(pbus_t *b, uint32_t v);                           // Data + WR strobe
+void pbus_write_buf(pbus_t *b, const void *src, uint32_t n);     // uint8_t (width <= 8) or uint16_t values
+uint32_t pbus_read(pbus_t *b);                                    // RD strobe + IDR
+
+// DMA burst: 'words' needs 2 * n entries (n without WR pin). Returns the number of words.
+uint32_t pbus_dma_prepare(const pbus_t *b, const void *src, uint32_t n, uint32_t *words);
+// Returns the real word rate, 0 if word_hz is too high or len is 0 / > 65535
+uint32_t pbus_dma_start(pbus_t *b, const uint32_t *words, uint32_t len, uint32_t word_hz);
+void pbus_dma_stop(void);
+uint8_t pbus_dma_busy(void);
+
+#endif /* INC_PBUS_H_ */
@@ -0,0 +1,28 @@
+/*
+ * GPIO waveform generator: TIM1 update -> DMA2 -> GPIOx->BSRR
+ *
+ * - TIM1 (APB2) update event every step, DMA2 Stream5 Channel6 (TIM1_UP)
+ *   writes the next word of a BSRR table to the port: all pins change on
+ *   the same AHB write, the step timing comes from the timer only
+ * - No CPU after wg_start(); looped (circular DMA) or single shot
+ * - Tables are built with wavepat.h
+ *
+ * Only DMA2 can reach the GPIO ports (AHB1), DMA1 cannot.
+ */
+
+#ifndef INC_WAVEGEN_H_
+#define INC_WAVEGEN_H_
+
+#include "stm32f4xx.h"
+
+#define WG_MAX_HZ_DIV    8U        // Step rate limit = TIM1 clock / WG_MAX_HZ_DIV (DMA + AHB access time)
+
+void wg_init(GPIO_TypeDef *port, uint16_t pins);      // Pins become push-pull outputs, high speed
+
+// Start streaming 'len' words (one per step) at step_hz.
+// Returns the real step rate, 0 if step_hz is too high or len is 0 / > 65535.
+uint32_t wg_start(const uint32_t *tab, uint32_t len, uint32_t step_hz, uint8_t loop);
+void wg_stop(void);
+uint8_t wg_busy(void);                                // Single shot still running
+
+#endif /* INC_WAVEGEN_H_ */
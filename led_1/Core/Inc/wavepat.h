@@ -0,0 +1,46 @@
+/*
+ * Waveform pattern compiler / renderer for the BSRR pattern generator (wavegen.h)
+ *
+ * Plain C, no register access: builds and checks tables on the target or on a PC.
+ *
+ * A table holds one BSRR word per step. Every step drives ALL pins of the
+ * pattern's pin mask (set or reset), pins outside the mask are never touched.
+ *
+ * Text description, one row per pin, separated by ';' (or new lines):
+ *     "5:--__--__; 6:-_-_-_-_"
+ *   pin number 0..15, then one character per step:
+ *     '1' '-' high,  '0' '_' low,  '.' same as the previous step
+ *   A row shorter than the longest one holds its last level.
+ */
+
+#ifndef INC_WAVEPAT_H_
+#define INC_WAVEPAT_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+	uint32_t *tab;                 // BSRR words, one per step
+	uint32_t cap;                  // Size of tab[]
+	uint32_t len;                  // Steps used
+	uint16_t pins;                 // Pins driven by the pattern
+	uint16_t level;                // Levels after the last step
+} wp_t;
+
+void wp_init(wp_t *p, uint32_t *buf, uint32_t cap, uint16_t pins);
+
+// Append steps, -1 if tab[] is full
+int wp_hold(wp_t *p, uint16_t levels, uint32_t steps);           // Same levels for 'steps' steps
+int wp_serial(wp_t *p, uint8_t clk_pin, uint8_t data_pin,
+              const uint8_t *data, uint32_t bytes);               // MSB first, 2 steps per bit, data valid on rising clk
+
+// Parse a text description (see above) and append it, -1 on a syntax error or overflow
+int wp_compile(wp_t *p, const char *desc);
+
+// Replay a table on a model of ODR (initial value 'odr') and draw every pin of 'pins':
+//   "P5  __--__--\n"   one character per step
+// Returns the string length, output cut at size - 1
+uint32_t wp_render(const uint32_t *tab, uint32_t len, uint16_t pins, uint16_t odr,
+                   char *out, uint32_t size);
+
+#endif /* INC_WAVEPAT_H_ */
@@ -1,48 +1,124 @@
 #include "stm32f4xx.h"
+#include "sched.h"
+#include "gpio_pin.h"
+#ifdef WAVEGEN_DEMO
+#include "wavegen.h"
+#include "wavepat.h"
+#endif
+#ifdef PBUS_DEMO
+#include "pbus.h"
+#endif
+
+#define BLINK_PRIO   1U
+#define BLINK_MS     200U
+#define LED          GPIOA, 5
 
-static void delay(volatile uint32_t count);
 static void gpio(void);
+static void blink_task(uint32_t events);
+#ifdef WAVEGEN_DEMO
+static void wavegen_demo(void);
+#endif
+#ifdef PBUS_DEMO
+static void pbus_demo(void);
+#endif
 
 int main(void)
 {
 	gpio();
-	while(1)                                  //infinte loop
-	{
-	    GPIOA->ODR ^= (1U << 5);             //toggling the bit
 
-	                                         /*
-	                                         * we can also use BSRR to set or reset the PA5 directly
-	                                         * to set
-	                                             GPIOA->BSRR = (1U << 5)
-	                                         * to reset after delay function
-	                                             GPIOA->BSRR = (1U <<(5+16))
-	                                         */
+	sched_init();
+	sched_add(BLINK_PRIO, blink_task);
+	sched_timer(BLINK_PRIO, BLINK_MS, BLINK_MS);    //periodic, replaces the NOP delay loop
 
-	    delay(200000);                       //Delay function
-	}
+#ifdef WAVEGEN_DEMO
+	wavegen_demo();                           //runs on DMA, no task needed
+#endif
+#ifdef PBUS_DEMO
+	pbus_demo();
+#endif
 
+	sched_run();                              //runs the tasks, sleeps (WFI) in between
+}
+
+static void blink_task(uint32_t events)
+{
+	if (events & SCHED_EVT_TIMER)
+	{
+	    PIN_TOGGLE(LED);                     //toggling the bit with one BSRR store
+	                                         //(PIN_SET / PIN_CLR set or reset PA5 directly)
+	}
 }
 
 static void gpio(void)
 {
-	    // GPIOA is on AHB1 bus
-		RCC->AHB1ENR |=RCC_AHB1ENR_GPIOAEN ;      //Enableing the clock for GPIOA
-		(void)RCC->AHB1ENR;                       // read-back to ensure clock is active
+	static const gpio_pin_cfg_t pa[] = { GP_OUTPUT(5, GP_PP, GP_LOW) };   //PA5 LED, push-pull, no pull
+
+	RCC->AHB1ENR |= GP_CLK(GPIOA);            //Enableing the clock for GPIOA
+	(void)RCC->AHB1ENR;                       // read-back to ensure clock is active
 
-		GPIOA->MODER &= ~(3U << 10);             //Clearing the moder PA5 bits
-		GPIOA->MODER |= (1U << 10);              // setting the moder  PA5 bits as output configuration
+	gpio_group_config(GPIOA, pa, 1);
+}
 
-		GPIOA->OTYPER &= ~(1U << 5);               //Push -Pull type
+#ifdef WAVEGEN_DEMO
+/*
+ * Serial frame on PA6 (clock) / PA7 (data) with a strobe on PA8,
+ * looped at 1 MHz steps by TIM1 + DMA2 (PA5 stays with the blink task)
+ */
+static uint32_t wave_tab[64];
 
-		GPIOA->OSPEEDR &= ~(3U << 10);           //Clearing the output speed PA5 bits
+static void wavegen_demo(void)
+{
+	static const uint8_t frame[2] = { 0x5A, 0xC3 };
+	wp_t p;
 
-		GPIOA->PUPDR &= ~(3U << 10);            //Clearing the PA5 PUPDR bits
+	wp_init(&p, wave_tab, 64, (1U << 6) | (1U << 7) | (1U << 8));
+	wp_compile(&p, "8:-_");                   //strobe pulse marks the frame start
+	wp_serial(&p, 6, 7, frame, 2);            //32 steps
+	wp_hold(&p, 0, 8);                        //idle gap
 
+	wg_init(GPIOA, p.pins);
+	wg_start(wave_tab, p.len, 1000000U, 1);
 }
-static void delay(volatile uint32_t count)
+#endif
+
+#ifdef PBUS_DEMO
+/*
+ * 8-bit bus on PC0..PC7, WR on PC8, RD on PC9 (8080 style display timing)
+ * CPU writes a few command bytes, reads one back, then a DMA burst at the
+ * highest word rate TIM8 allows: 16 MHz HSI / PBUS_MAX_HZ_DIV = 2 M words/s,
+ * two words per byte (data + WR low, WR high) = 1 MB/s
+ */
+static pbus_t bus;
+static uint8_t burst_data[256];
+static uint32_t burst_words[512];
+volatile uint32_t pbus_status;
+volatile uint32_t pbus_rate;        //real DMA word rate, 0 = burst not started
+
+static void pbus_demo(void)
 {
-    while (count--)
-    {
-    	__asm volatile ("nop");                  //the loop that cannot be optimized away
-    }
+	static const pbus_timing_t t = { 10, 15, 40 };     //setup, pulse, access in ns
+	static const uint8_t cmd[3] = { 0x2A, 0x00, 0x7F };
+	uint32_t words;
+
+	if (pbus_init(&bus, GPIOC, 0, 8, 8, 9, &t) != 0)
+	{
+		return;
+	}
+
+	pbus_write_buf(&bus, cmd, 3);
+	pbus_status = pbus_read(&bus);
+
+	for (uint32_t i = 0; i < 256U; i++)
+	{
+		burst_data[i] = (uint8_t)i;
+	}
+	words = pbus_dma_prepare(&bus, burst_data, 256, burst_words);
+
+	//TIM8 runs at SYSCLK here (APB2 prescaler 1)
+	pbus_rate = pbus_dma_start(&bus, burst_words, words, SystemCoreClock / PBUS_MAX_HZ_DIV);
+	if (pbus_rate == 0U)
+	{
+		pbus_status = 0xFFFFFFFFU;            //rate out of range, no burst
+	}
 }
+#endif
@@ -0,0 +1,285 @@
+/*
+ * Parallel bus driver (see pbus.h)
+ */
+
+#include "pbus.h"
+#include "regclr.h"
+#include "gpio_pin.h"
+
+/*==========================================================*/
+/*
+ * Timing: DWT cycle counter, ns rounded up to whole core clocks
+ */
+
+static uint32_t ns_to_cycles(uint32_t ns)
+{
+	uint32_t mhz = SystemCoreClock / 1000000U;
+
+	return ((ns * mhz) + 999U) / 1000U;
+}
+
+static inline void wait_cycles(uint32_t start, uint32_t cyc)
+{
+	while ((DWT->CYCCNT - start) < cyc){}
+}
+
+/*
+ * TIM8 clock
+ * - APB2 prescaler = 1 -> timer clock = PCLK2
+ * - APB2 prescaler > 1 -> timer clock = 2 x PCLK2
+ */
+static uint32_t pbus_timer_clock(void)
+{
+	uint32_t ppre2 = (RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos;
+
+	if (APBPrescTable[ppre2] == 0U)
+	{
+		return SystemCoreClock;
+	}
+	return (SystemCoreClock >> APBPrescTable[ppre2]) * 2U;
+}
+
+/*==========================================================*/
+
+int pbus_init(pbus_t *b, GPIO_TypeDef *port, uint32_t shift, uint32_t width,
+              uint32_t wr_pin, uint32_t rd_pin, const pbus_timing_t *t)
+{
+	if ((width == 0U) || (width > 16U) || ((shift + width) > 16U) ||
+	    ((wr_pin != PBUS_NO_PIN) && (wr_pin > 15U)) || ((rd_pin != PBUS_NO_PIN) && (rd_pin > 15U)))
+	{
+		return -1;
+	}
+
+	SystemCoreClockUpdate();
+
+	b->port = port;
+	b->shift = shift;
+	b->width = width;
+	b->mask = ((1UL << width) - 1U) << shift;
+	b->clr = b->mask << 16;
+	b->wr = (wr_pin != PBUS_NO_PIN) ? (1U << wr_pin) : 0U;
+	b->rd = (rd_pin != PBUS_NO_PIN) ? (1U << rd_pin) : 0U;
+	if ((b->mask & (b->wr | b->rd)) != 0U)
+	{
+		return -1;                                       // Strobe inside the data pins
+	}
+
+	b->wr_cyc = ns_to_cycles((t->setup_ns > t->pulse_ns) ? t->setup_ns : t->pulse_ns);
+	b->rd_cyc = ns_to_cycles((t->access_ns > t->pulse_ns) ? t->access_ns : t->pulse_ns);
+	b->mode_m2 = gpio_mask2(b->mask);
+	b->mode_out = b->mode_m2 & 0x55555555U;
+
+	// Cycle counter for the strobe timing
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	RCC->AHB1ENR |= GP_CLK(port) | RCC_AHB1ENR_DMA2EN;
+	RCC->APB2ENR |= RCC_APB2ENR_TIM8EN;
+	(void)RCC->APB2ENR;
+
+	// Strobes idle high before they become outputs
+	port->BSRR = b->wr | b->rd;
+	gpio_mask_config(port, b->wr | b->rd, GP_OUT, GP_PP, GP_HIGH, GP_NOPULL);
+	gpio_mask_config(port, b->mask, GP_OUT, GP_PP, GP_HIGH, GP_NOPULL);
+	b->in = 0;
+
+	TIM8->CR1 = 0;
+	TIM8->DIER = 0;
+
+	DMA2_Stream1->CR &= ~DMA_SxCR_EN;
+	while (DMA2_Stream1->CR & DMA_SxCR_EN){}
+	DMA2_Stream1->PAR = (uint32_t)&port->BSRR;
+
+	NVIC_SetPriority(DMA2_Stream1_IRQn, 3);
+	NVIC_EnableIRQ(DMA2_Stream1_IRQn);
+
+	return 0;
+}
+
+// Direction: one MODER write each, pull / speed stay as set up
+void pbus_output(pbus_t *b)
+{
+	b->port->MODER = (b->port->MODER & ~b->mode_m2) | b->mode_out;
+	b->in = 0;
+}
+
+void pbus_input(pbus_t *b)
+{
+	b->port->MODER &= ~b->mode_m2;
+	b->in = 1;
+}
+
+/*==========================================================*/
+
+void pbus_write(pbus_t *b, uint32_t v)
+{
+	GPIO_TypeDef *port = b->port;
+	uint32_t t;
+
+	if (b->in)
+	{
+		pbus_output(b);
+	}
+
+	port->BSRR = pbus_word(b, v) | (b->wr << 16);        // Data + WR low, one store
+	t = DWT->CYCCNT;
+	wait_cycles(t, b->wr_cyc);
+	port->BSRR = b->wr;                                  // Rising edge latches
+}
+
+void pbus_write_buf(pbus_t *b, const void *src, uint32_t n)
+{
+	GPIO_TypeDef *port = b->port;
+	uint32_t wr_lo = b->wr << 16;
+	uint32_t t;
+
+	if (b->in)
+	{
+		pbus_output(b);
+	}
+
+	// Two stores per value, the loop is only limited by wr_cyc and the AHB writes
+	if (b->width <= 8U)
+	{
+		const uint8_t *p = src;
+
+		for (uint32_t i = 0; i < n; i++)
+		{
+			port->BSRR = pbus_word(b, p[i]) | wr_lo;
+			t = DWT->CYCCNT;
+			wait_cycles(t, b->wr_cyc);
+			port->BSRR = b->wr;
+		}
+	}
+	else
+	{
+		const uint16_t *p = src;
+
+		for (uint32_t i = 0; i < n; i++)
+		{
+			port->BSRR = pbus_word(b, p[i]) | wr_lo;
+			t = DWT->CYCCNT;
+			wait_cycles(t, b->wr_cyc);
+			port->BSRR = b->wr;
+		}
+	}
+}
+
+uint32_t pbus_read(pbus_t *b)
+{
+	GPIO_TypeDef *port = b->port;
+	uint32_t t, v;
+
+	if (!b->in)
+	{
+		pbus_input(b);
+	}
+
+	port->BSRR = b->rd << 16;                            // RD low, device drives the bus
+	t = DWT->CYCCNT;
+	wait_cycles(t, b->rd_cyc);
+	v = port->IDR;
+	port->BSRR = b->rd;
+
+	return (v & b->mask) >> b->shift;
+}
+
+/*==========================================================*/
+/*
+ * DMA burst
+ * With a WR pin every value takes two words (data + WR low, WR high), so WR low
+ * time = one word period and the write rate is word_hz / 2.
+ */
+
+uint32_t pbus_dma_prepare(const pbus_t *b, const void *src, uint32_t n, uint32_t *words)
+{
+	uint32_t k = 0;
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		uint32_t v = (b->width <= 8U) ? ((const uint8_t *)src)[i] : ((const uint16_t *)src)[i];
+
+		if (b->wr != 0U)
+		{
+			words[k++] = pbus_word(b, v) | (b->wr << 16);
+			words[k++] = b->wr;
+		}
+		else
+		{
+			words[k++] = pbus_word(b, v);
+		}
+	}
+	return k;
+}
+
+uint32_t pbus_dma_start(pbus_t *b, const uint32_t *words, uint32_t len, uint32_t word_hz)
+{
+	uint32_t timclk = pbus_timer_clock();
+	uint32_t div;
+	uint32_t psc = 0;
+
+	if ((len == 0U) || (len > 0xFFFFU) || (word_hz == 0U) || (word_hz > (timclk / PBUS_MAX_HZ_DIV)))
+	{
+		return 0;
+	}
+
+	div = (timclk + (word_hz / 2U)) / word_hz;
+	while ((div / (psc + 1U)) > 0x10000U)
+	{
+		psc++;
+	}
+
+	pbus_dma_stop();
+	if (b->in)
+	{
+		pbus_output(b);
+	}
+
+	TIM8->PSC = psc;
+	TIM8->ARR = (div / (psc + 1U)) - 1U;
+	TIM8->RCR = 0;
+	TIM8->CNT = 0;
+	TIM8->EGR = TIM_EGR_UG;                              // Load PSC, no DMA request yet (UDE off)
+	TIM8->SR = 0;
+
+	dma_stream_clear(DMA2, 1);
+	DMA2_Stream1->M0AR = (uint32_t)words;
+	DMA2_Stream1->NDTR = len;
+
+	// Channel7 (TIM8_UP), memory -> peripheral, 32-bit both sides, memory increment, very high priority
+	DMA2_Stream1->CR = (7U << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL | DMA_SxCR_MSIZE_1 |
+	                   DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_TCIE;
+	DMA2_Stream1->CR |= DMA_SxCR_EN;
+
+	TIM8->DIER = TIM_DIER_UDE;
+	TIM8->CR1 |= TIM_CR1_CEN;
+
+	return timclk / ((psc + 1U) * (TIM8->ARR + 1U));
+}
+
+void pbus_dma_stop(void)
+{
+	TIM8->CR1 &= ~TIM_CR1_CEN;
+	TIM8->DIER = 0;
+
+	DMA2_Stream1->CR &= ~DMA_SxCR_EN;
+	while (DMA2_Stream1->CR & DMA_SxCR_EN){}
+}
+
+uint8_t pbus_dma_busy(void)
+{
+	return (DMA2_Stream1->CR & DMA_SxCR_EN) ? 1U : 0U;
+}
+
+/*==========================================================*/
+
+// Burst done: timer stopped so it does not keep requesting
+void DMA2_Stream1_IRQHandler(void)
+{
+	if (DMA2->LISR & DMA_LISR_TCIF1)
+	{
+		reg_clear_w1(&DMA2->LIFCR, DMA_LIFCR_CTCIF1);
+		TIM8->CR1 &= ~TIM_CR1_CEN;
+		TIM8->DIER = 0;
+	}
+}
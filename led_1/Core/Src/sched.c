@@ -0,0 +1,133 @@
+/*
+ * Cooperative run-to-completion scheduler (see sched.h)
+ */
+
+#include "sched.h"
+
+typedef struct
+{
+	sched_task_t fn;
+	volatile uint32_t events;      // Pending, handed over on the next run
+	uint32_t deadline;             // Absolute tick of the next timer expiry
+	uint32_t period;               // 0 = one-shot
+	uint8_t timer_on;
+} sched_tcb_t;
+
+static sched_tcb_t tasks[SCHED_MAX_TASKS];
+static volatile uint32_t ready;                // Bit n set = task n has events
+static volatile uint32_t ticks;
+
+/*==========================================================*/
+
+void sched_init(void)
+{
+	for (uint32_t i = 0; i < SCHED_MAX_TASKS; i++)
+	{
+		tasks[i].fn = 0;
+		tasks[i].events = 0;
+		tasks[i].timer_on = 0;
+	}
+	ready = 0;
+	ticks = 0;
+
+	SystemCoreClockUpdate();
+	SysTick_Config(SystemCoreClock / SCHED_TICK_HZ);
+	NVIC_SetPriority(SysTick_IRQn, 15);                 // Lowest, only the timer service runs there
+}
+
+int sched_add(uint32_t prio, sched_task_t task)
+{
+	if ((prio >= SCHED_MAX_TASKS) || (tasks[prio].fn != 0))
+	{
+		return -1;
+	}
+	tasks[prio].fn = task;
+	return 0;
+}
+
+void sched_post(uint32_t prio, uint32_t events)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	tasks[prio].events |= events;
+	ready |= (1U << prio);
+	__set_PRIMASK(primask);
+}
+
+void sched_timer(uint32_t prio, uint32_t delay_ms, uint32_t period_ms)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	tasks[prio].deadline = ticks + delay_ms;
+	tasks[prio].period = period_ms;
+	tasks[prio].timer_on = 1;
+	__set_PRIMASK(primask);
+}
+
+void sched_timer_stop(uint32_t prio)
+{
+	tasks[prio].timer_on = 0;
+}
+
+uint32_t sched_now(void)
+{
+	return ticks;
+}
+
+/*==========================================================*/
+
+void sched_tick(void)
+{
+	uint32_t now = ++ticks;
+
+	for (uint32_t i = 0; i < SCHED_MAX_TASKS; i++)
+	{
+		sched_tcb_t *t = &tasks[i];
+
+		if (t->timer_on && ((int32_t)(now - t->deadline) >= 0))
+		{
+			if (t->period != 0U)
+			{
+				t->deadline += t->period;
+			}
+			else
+			{
+				t->timer_on = 0;
+			}
+			t->events |= SCHED_EVT_TIMER;
+			ready |= (1U << i);
+		}
+	}
+}
+
+void sched_run(void)
+{
+	while (1)
+	{
+		__disable_irq();
+
+		if (ready == 0U)
+		{
+			// A pending interrupt still ends WFI with PRIMASK set, so nothing posted
+			// between the check and the sleep is lost. It runs after __enable_irq().
+			__WFI();
+			__enable_irq();
+			continue;
+		}
+
+		// Highest ready priority, one CLZ
+		uint32_t prio = 31U - __CLZ(ready);
+		uint32_t events = tasks[prio].events;
+
+		tasks[prio].events = 0;
+		ready &= ~(1U << prio);
+		__enable_irq();
+
+		if (tasks[prio].fn != 0)
+		{
+			tasks[prio].fn(events);
+		}
+	}
+}
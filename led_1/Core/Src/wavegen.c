@@ -0,0 +1,111 @@
+/*
+ * GPIO waveform generator (see wavegen.h)
+ */
+
+#include "wavegen.h"
+#include "regclr.h"
+#include "gpio_pin.h"
+
+static GPIO_TypeDef *wg_port;
+
+/*==========================================================*/
+/*
+ * TIM1 clock
+ * - APB2 prescaler = 1 -> timer clock = PCLK2
+ * - APB2 prescaler > 1 -> timer clock = 2 x PCLK2
+ */
+
+static uint32_t wg_timer_clock(void)
+{
+	uint32_t ppre2 = (RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos;
+
+	SystemCoreClockUpdate();
+
+	if (APBPrescTable[ppre2] == 0U)
+	{
+		return SystemCoreClock;
+	}
+	return (SystemCoreClock >> APBPrescTable[ppre2]) * 2U;
+}
+
+void wg_init(GPIO_TypeDef *port, uint16_t pins)
+{
+	wg_port = port;
+
+	RCC->AHB1ENR |= GP_CLK(port) | RCC_AHB1ENR_DMA2EN;
+	(void)RCC->AHB1ENR;
+
+	// Push-pull outputs, very high speed for sharp MHz edges
+	gpio_mask_config(port, pins, GP_OUT, GP_PP, GP_HIGH, GP_NOPULL);
+
+	RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+	(void)RCC->APB2ENR;
+
+	TIM1->CR1 &= ~TIM_CR1_CEN;
+	TIM1->DIER = 0;
+
+	DMA2_Stream5->CR &= ~DMA_SxCR_EN;
+	while (DMA2_Stream5->CR & DMA_SxCR_EN){}
+	DMA2_Stream5->PAR = (uint32_t)&port->BSRR;
+}
+
+uint32_t wg_start(const uint32_t *tab, uint32_t len, uint32_t step_hz, uint8_t loop)
+{
+	uint32_t timclk = wg_timer_clock();
+	uint32_t div;
+	uint32_t psc = 0;
+
+	if ((len == 0U) || (len > 0xFFFFU) || (step_hz == 0U) || (step_hz > (timclk / WG_MAX_HZ_DIV)))
+	{
+		return 0;
+	}
+
+	// Timer period in clocks, prescaler only once ARR (16 bit) runs out
+	div = (timclk + (step_hz / 2U)) / step_hz;
+	while ((div / (psc + 1U)) > 0x10000U)
+	{
+		psc++;
+	}
+
+	wg_stop();
+
+	TIM1->PSC = psc;
+	TIM1->ARR = (div / (psc + 1U)) - 1U;
+	TIM1->RCR = 0;                                       // Update on every period
+	TIM1->CNT = 0;
+	TIM1->EGR = TIM_EGR_UG;                              // Load PSC, no DMA request yet (UDE off)
+	TIM1->SR = 0;
+
+	dma_stream_clear(DMA2, 5);                           // Clear all Stream5 flags
+	DMA2_Stream5->M0AR = (uint32_t)tab;
+	DMA2_Stream5->NDTR = len;
+
+	// Channel6, memory -> peripheral, 32-bit both sides, memory increment, very high priority
+	DMA2_Stream5->CR = (6U << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_PL | DMA_SxCR_MSIZE_1 |
+	                   DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0;
+	if (loop)
+	{
+		DMA2_Stream5->CR |= DMA_SxCR_CIRC;
+	}
+	DMA2_Stream5->CR |= DMA_SxCR_EN;
+
+	// First word at the first update event, then one per step
+	TIM1->DIER = TIM_DIER_UDE;
+	TIM1->CR1 |= TIM_CR1_CEN;
+
+	return timclk / ((psc + 1U) * (TIM1->ARR + 1U));
+}
+
+void wg_stop(void)
+{
+	TIM1->CR1 &= ~TIM_CR1_CEN;
+	TIM1->DIER = 0;
+
+	DMA2_Stream5->CR &= ~DMA_SxCR_EN;
+	while (DMA2_Stream5->CR & DMA_SxCR_EN){}
+}
+
+uint8_t wg_busy(void)
+{
+	return (DMA2_Stream5->CR & DMA_SxCR_EN) ? 1U : 0U;
+}
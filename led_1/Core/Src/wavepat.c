@@ -0,0 +1,252 @@
+/*
+ * Waveform pattern compiler / renderer (see wavepat.h)
+ */
+
+#include "wavepat.h"
+
+#define WP_MAX_STEPS_ROW   1024U           // Longest row accepted by wp_compile()
+
+/*==========================================================*/
+
+static uint32_t bsrr_word(uint16_t pins, uint16_t levels)
+{
+	// Low half sets, high half resets; set wins if both, never happens here
+	return (uint32_t)(levels & pins) | ((uint32_t)(~levels & pins) << 16);
+}
+
+void wp_init(wp_t *p, uint32_t *buf, uint32_t cap, uint16_t pins)
+{
+	p->tab = buf;
+	p->cap = cap;
+	p->len = 0;
+	p->pins = pins;
+	p->level = 0;
+}
+
+int wp_hold(wp_t *p, uint16_t levels, uint32_t steps)
+{
+	if ((p->cap - p->len) < steps)
+	{
+		return -1;
+	}
+
+	uint32_t w = bsrr_word(p->pins, levels);
+
+	for (uint32_t i = 0; i < steps; i++)
+	{
+		p->tab[p->len++] = w;
+	}
+	p->level = levels & p->pins;
+	return 0;
+}
+
+int wp_serial(wp_t *p, uint8_t clk_pin, uint8_t data_pin, const uint8_t *data, uint32_t bytes)
+{
+	uint16_t clk = (uint16_t)(1U << clk_pin);
+	uint16_t dat = (uint16_t)(1U << data_pin);
+
+	if ((p->cap - p->len) < (bytes * 16U))
+	{
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < bytes; i++)
+	{
+		for (uint32_t bit = 0x80U; bit != 0U; bit >>= 1)
+		{
+			uint16_t lv = (uint16_t)(p->level & ~(clk | dat));
+
+			if (data[i] & bit)
+			{
+				lv |= dat;
+			}
+			wp_hold(p, lv, 1);                 // Clock low, data changes
+			wp_hold(p, lv | clk, 1);           // Clock high, data sampled
+		}
+	}
+	return 0;
+}
+
+/*==========================================================*/
+/*
+ * Two passes: the first checks the syntax and finds the longest row,
+ * the second fills the table column by column
+ */
+
+static const char *skip_sep(const char *s)
+{
+	while ((*s == ' ') || (*s == ';') || (*s == '\n') || (*s == '\r') || (*s == '\t'))
+	{
+		s++;
+	}
+	return s;
+}
+
+static int is_step(char c)
+{
+	return (c == '1') || (c == '-') || (c == '0') || (c == '_') || (c == '.');
+}
+
+// Parses "pin:" at s, returns the step string or 0 on error
+static const char *parse_pin(const char *s, uint32_t *pin)
+{
+	uint32_t n = 0;
+
+	if ((*s < '0') || (*s > '9'))
+	{
+		return 0;
+	}
+	while ((*s >= '0') && (*s <= '9'))
+	{
+		n = (n * 10U) + (uint32_t)(*s - '0');
+		s++;
+	}
+	if ((*s != ':') || (n > 15U))
+	{
+		return 0;
+	}
+	*pin = n;
+	return s + 1;
+}
+
+int wp_compile(wp_t *p, const char *desc)
+{
+	const char *s;
+	uint32_t steps = 0;
+	uint32_t pin = 0;
+
+	// Pass 1: syntax, pins, longest row
+	s = skip_sep(desc);
+	while (*s != '\0')
+	{
+		uint32_t n = 0;
+
+		s = parse_pin(s, &pin);
+		if ((s == 0) || !(p->pins & (1U << pin)))
+		{
+			return -1;
+		}
+		while (is_step(*s))
+		{
+			s++;
+			n++;
+		}
+		if ((n > WP_MAX_STEPS_ROW) || ((*s != '\0') && (skip_sep(s) == s)))
+		{
+			return -1;
+		}
+		if (n > steps)
+		{
+			steps = n;
+		}
+		s = skip_sep(s);
+	}
+
+	if ((p->cap - p->len) < steps)
+	{
+		return -1;
+	}
+
+	// Pass 2: every row writes its pin into the new columns.
+	// The columns hold plain level masks first, pins without a row keep their level.
+	uint32_t base = p->len;
+
+	for (uint32_t i = 0; i < steps; i++)
+	{
+		p->tab[base + i] = p->level;
+	}
+
+	s = skip_sep(desc);
+	while (*s != '\0')
+	{
+		uint32_t bit;
+		uint32_t level;
+		uint32_t i = 0;
+
+		s = parse_pin(s, &pin);
+		bit = 1U << pin;
+		level = p->level & bit;
+
+		for (; i < steps; i++)
+		{
+			if (is_step(*s))
+			{
+				if ((*s == '1') || (*s == '-'))
+				{
+					level = bit;
+				}
+				else if ((*s == '0') || (*s == '_'))
+				{
+					level = 0;
+				}
+				s++;
+			}
+			p->tab[base + i] = (p->tab[base + i] & ~bit) | level;
+		}
+		s = skip_sep(s);
+	}
+
+	// Level masks -> BSRR words
+	for (uint32_t i = 0; i < steps; i++)
+	{
+		p->tab[base + i] = bsrr_word(p->pins, (uint16_t)p->tab[base + i]);
+	}
+	if (steps != 0U)
+	{
+		p->level = (uint16_t)(p->tab[base + steps - 1U] & p->pins);
+	}
+	p->len += steps;
+
+	return 0;
+}
+
+/*==========================================================*/
+
+uint32_t wp_render(const uint32_t *tab, uint32_t len, uint16_t pins, uint16_t odr,
+                   char *out, uint32_t size)
+{
+	uint32_t o = 0;
+
+	if (size == 0U)
+	{
+		return 0;
+	}
+
+	for (uint32_t pin = 0; pin < 16U; pin++)
+	{
+		uint16_t bit = (uint16_t)(1U << pin);
+		uint16_t v = odr;
+		char head[5] = { 'P', (char)('0' + (pin / 10U)), (char)('0' + (pin % 10U)), ' ', ' ' };
+
+		if (!(pins & bit))
+		{
+			continue;
+		}
+		if (pin < 10U)
+		{
+			head[1] = (char)('0' + pin);
+			head[2] = ' ';
+		}
+
+		for (uint32_t i = 0; (i < 5U) && (o < (size - 1U)); i++)
+		{
+			out[o++] = head[i];
+		}
+
+		for (uint32_t i = 0; (i < len) && (o < (size - 1U)); i++)
+		{
+			// BSRR: reset half first, set half wins
+			v &= (uint16_t)~(tab[i] >> 16);
+			v |= (uint16_t)tab[i];
+			out[o++] = (v & bit) ? '-' : '_';
+		}
+
+		if (o < (size - 1U))
+		{
+			out[o++] = '\n';
+		}
+	}
+
+	out[o] = '\0';
+	return o;
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <string.h>
+#include "wavepat.h"
+
+/*
+ * Host check of wavepat.c
+ * - The WAVEGEN_DEMO frame (main.c) renders to the expected waveform
+ * - wp_compile() rows, '.' hold, short rows, pins without a row
+ * - Syntax errors and table overflow return -1 and leave the table alone
+ * - wp_render() output is cut at size - 1
+ * Returns 0 when everything matches, prints the failing checks otherwise.
+ */
+
+#define PIN(n)   (1U << (n))
+
+static unsigned failures;
+
+static void check(int ok, const char *what)
+{
+	if (!ok)
+	{
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+/*==========================================================*/
+/*
+ * Same table as wavegen_demo(): strobe on PA8, 0x5A 0xC3 on PA6 (clock) / PA7 (data),
+ * 8 idle steps
+ */
+
+static void check_demo(void)
+{
+	static const uint8_t frame[2] = { 0x5A, 0xC3 };
+	static const char expect[] =
+		"P6   ___-_-_-_-_-_-_-_-_-_-_-_-_-_-_-_-________\n"
+		"P7   ____--__----__--__----________----________\n"
+		"P8   -_________________________________________\n";
+	uint32_t tab[64];
+	char out[256];
+	wp_t p;
+
+	wp_init(&p, tab, 64, PIN(6) | PIN(7) | PIN(8));
+	check(wp_compile(&p, "8:-_") == 0, "demo strobe compiles");
+	check(wp_serial(&p, 6, 7, frame, 2) == 0, "demo frame fits");
+	check(wp_hold(&p, 0, 8) == 0, "demo idle gap fits");
+	check(p.len == 42U, "demo is 42 steps");
+
+	wp_render(tab, p.len, p.pins, 0, out, sizeof(out));
+	printf("%s", out);
+	check(strcmp(out, expect) == 0, "demo waveform");
+
+	// Every step drives exactly the three pattern pins
+	for (uint32_t i = 0; i < p.len; i++)
+	{
+		if ((((tab[i] >> 16) | tab[i]) & 0xFFFFU) != p.pins)
+		{
+			check(0, "demo step drives every pattern pin");
+			break;
+		}
+	}
+}
+
+/*==========================================================*/
+
+static void check_compile(void)
+{
+	uint32_t tab[32];
+	char out[128];
+	wp_t p;
+
+	// '.' repeats, a short row holds its last level, pin 2 has no row and stays high
+	wp_init(&p, tab, 32, PIN(2) | PIN(5) | PIN(12));
+	check(wp_hold(&p, PIN(2), 1) == 0, "hold before compile");
+	check(wp_compile(&p, "5:-..__.;\n 12:0-") == 0, "compile two rows");
+	check(p.len == 7U, "hold step + longest row");
+	check(p.level == (PIN(2) | PIN(12)), "levels after the last step");
+
+	wp_render(tab, p.len, p.pins, 0, out, sizeof(out));
+	check(strcmp(out,
+	             "P2   -------\n"
+	             "P5   _---___\n"
+	             "P12  __-----\n") == 0, "compiled waveform");
+
+	// An empty description adds nothing
+	check(wp_compile(&p, " ; \n") == 0, "empty description");
+	check(p.len == 7U, "empty description adds no step");
+}
+
+static void check_errors(void)
+{
+	static const char *const bad[] =
+	{
+		"5--__",           // no ':'
+		"16:-_",           // pin out of range
+		"4:-_",            // pin not in the pattern
+		"5:-x_",           // unknown step character
+		":-_",             // no pin number
+		"5:-_ 6:-_ 7",     // row without ':'
+	};
+	static const uint8_t byte = 0xFF;
+	uint32_t tab[8];
+	wp_t p;
+
+	wp_init(&p, tab, 8, PIN(5) | PIN(6));
+
+	for (uint32_t i = 0; i < (sizeof(bad) / sizeof(bad[0])); i++)
+	{
+		check(wp_compile(&p, bad[i]) == -1, bad[i]);
+	}
+	check(p.len == 0U, "syntax errors add nothing");
+
+	// Overflow: 9 steps into 8, 16 serial steps into 8, hold past the end
+	check(wp_compile(&p, "5:-_-_-_-_-") == -1, "compile overflow");
+	check(wp_serial(&p, 5, 6, &byte, 1) == -1, "serial overflow");
+	check(wp_hold(&p, 0, 9) == -1, "hold overflow");
+	check(p.len == 0U, "overflow adds nothing");
+
+	check(wp_hold(&p, 0, 8) == 0, "exact fit");
+	check(wp_hold(&p, 0, 1) == -1, "full table");
+}
+
+static void check_render_cut(void)
+{
+	uint32_t tab[4];
+	char out[8];
+	wp_t p;
+
+	wp_init(&p, tab, 4, PIN(0) | PIN(1));
+	wp_hold(&p, PIN(0), 4);
+
+	check(wp_render(tab, p.len, p.pins, 0, out, sizeof(out)) == 7U, "render cut at size - 1");
+	check(strcmp(out, "P0   --") == 0, "cut output is terminated");
+	check(wp_render(tab, p.len, p.pins, 0, out, 0) == 0U, "size 0 writes nothing");
+}
+
+int main(void)
+{
+	check_demo();
+	check_compile();
+	check_errors();
+	check_render_cut();
+
+	printf("%s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}
@@ -1,55 +1,50 @@
 /*
  * LED ON when button pressed ,OFF when not pressed (relesed)
+ * Button debounced by the TIM3 sampling service (debounce.h), the CPU sleeps in between
  */
 #include "stm32f4xx.h"
+#include "debounce.h"
+#include "gpio_pin.h"
+
+#define LED      GPIOA, 5
+#define BUTTON   GPIOC, 13
 
 static void gpio_config(void);
 
 int main(void)
 {
 	gpio_config();
+
+	deb_init();                                                   //TIM3 samples every 5 ms
+	deb_add(PIN_PORT(BUTTON), PIN_MASK(BUTTON), PIN_MASK(BUTTON));   //PC13, pressed = low
 	while(1)                                                      //infinte loop
 	{
-		if(!(GPIOC->IDR & (1U << 13)))
+		deb_event_t ev;
+
+		while(deb_read(&ev))
 		{
-			for(volatile uint32_t count=0;count<20000;count++);   //delay to overcome bouncing effect
-			if(!(GPIOC->IDR & (1U << 13)))
+			if(ev.pressed)
 			{
-				GPIOA->BSRR = (1U << 5);                           //LED on
-
-				while(!(GPIOC->IDR & (1U << 13)));                    //wait untile switch relese
-				GPIOA->BSRR = (1U <<(5+16));                       //LED off
+				PIN_SET(LED);                                      //LED on
+			}
+			else
+			{
+				PIN_CLR(LED);                                      //LED off
 			}
 		}
+		__WFI();                                                  //sleep until the next sample
 	}
 
 }
 
 static void gpio_config(void)
 {
-	    // GPIOA is on AHB1 bus
-		RCC->AHB1ENR |=RCC_AHB1ENR_GPIOAEN ;      //Enableing the clock for GPIO
-
-		// GPIOC is on AHB1 bus
-		RCC->AHB1ENR |=RCC_AHB1ENR_GPIOCEN ;      //Enableing the clock for GPIOA
-		(void)RCC->AHB1ENR;                       // read-back to ensure clock is active
-		//-------------------------------------
-
-		GPIOA->MODER &= ~(3U << 10);             //Clearing the moder PA5 bits
-		GPIOA->MODER |= (1U << 10);              // setting the moder  PA5 bits as output configuration
-
-		GPIOA->OTYPER &= ~(1U << 5);               //Push -Pull type
-
-		GPIOA->OSPEEDR &= ~(3U << 10);           //Clearing the output speed PA5 bits
-
-		GPIOA->PUPDR &= ~(3U << 10);            //Clearing the PA5 PUPDR bits
-		//--------------------------------------
-
-		GPIOC->MODER &= ~(3U << 26);             //Clearing the moder PC13 bits to config as input mode
-
-		GPIOC->OSPEEDR &= ~(3U << 26);           //Clearing the output speed PC13 bits to set  low speed
+	static const gpio_pin_cfg_t pa[] = { GP_OUTPUT(5, GP_PP, GP_LOW) };   //PA5 LED, push-pull
+	static const gpio_pin_cfg_t pc[] = { GP_INPUT(13, GP_UP) };           //PC13 button, pull-up
 
-		GPIOC->PUPDR &= ~(3U << 26);            //Clearing the PC13 PUPDR bits
-		GPIOC->PUPDR |= (1U << 26);             // config as pull-up
+	RCC->AHB1ENR |= GP_CLK(GPIOA) | GP_CLK(GPIOC);   //both ports, one write
+	(void)RCC->AHB1ENR;                              // read-back to ensure clock is active
 
+	gpio_group_config(GPIOA, pa, 1);                 //one RMW per register and port
+	gpio_group_config(GPIOC, pc, 1);
 }
@@ -0,0 +1,41 @@
+/*
+ * Debounce service for whole GPIO ports
+ *
+ * - TIM3 interrupt samples every registered port each DEB_SAMPLE_MS
+ * - All 16 pins of a port are debounced at once, bit-parallel:
+ *   a 2-bit vertical counter per pin, a new level is taken after
+ *   4 equal samples in a row (4 x DEB_SAMPLE_MS = 20 ms)
+ * - Every accepted change becomes an event with a timestamp in a ring,
+ *   the main loop reads them with deb_read(), nothing ever blocks
+ */
+
+#ifndef INC_DEBOUNCE_H_
+#define INC_DEBOUNCE_H_
+
+#include "stm32f4xx.h"
+
+#define DEB_SAMPLE_MS    5U
+#define DEB_MAX_PORTS    4U
+#define DEB_RING_LEN     32U          // Events kept, power of two
+
+typedef struct
+{
+	uint32_t ts_ms;                   // Time of the accepted change (ms since deb_init())
+	uint8_t  port;                    // Index returned by deb_add()
+	uint8_t  pin;
+	uint8_t  pressed;                 // 1 = pin went to its active level
+} deb_event_t;
+
+void deb_init(void);                  // Start the TIM3 sampling
+
+// Debounce 'mask' pins of 'port' (inputs, configured by the caller).
+// active_low: pins whose pressed state is 0 (button to GND with pull-up).
+// Returns the port index, -1 if all DEB_MAX_PORTS are in use.
+int deb_add(GPIO_TypeDef *port, uint16_t mask, uint16_t active_low);
+
+uint8_t deb_read(deb_event_t *ev);    // 1 = event returned, 0 = none
+uint16_t deb_state(uint32_t port);    // Debounced pin levels
+uint32_t deb_lost(void);              // Events dropped, ring full
+uint32_t deb_now(void);               // Sample clock, same time base as ts_ms
+
+#endif /* INC_DEBOUNCE_H_ */
@@ -0,0 +1,57 @@
+/*
+ * Button gestures from debounced, timestamped edges (debounce.h)
+ *
+ * - Click, double click, long press, auto-repeat while held, end of a long press
+ * - One small state machine per button, transitions come from a const table
+ *   (state x input -> next state, event, timer), inputs are press, release
+ *   and the button's own timeout
+ * - Timeouts are deadlines computed from the edge timestamps, not from when
+ *   the main loop gets around to it: a late gst_run() still decides a double
+ *   click by the real time between the presses
+ * - gst_run() drains the debounce ring and expires deadlines; with nothing
+ *   armed it costs one compare, the main loop can sleep between TIM3 samples
+ */
+
+#ifndef INC_GESTURE_H_
+#define INC_GESTURE_H_
+
+#include "stm32f4xx.h"
+#include "debounce.h"
+
+#define GST_MAX_BUTTONS    16U
+#define GST_RING_LEN       16U         // Gesture events kept, power of two
+
+typedef enum
+{
+	GST_NONE = 0,
+	GST_CLICK,                         // Short press, no second press within dbl_ms
+	GST_DOUBLE,                        // Second press released
+	GST_LONG,                          // Held for long_ms
+	GST_REPEAT,                        // Every repeat_ms after GST_LONG while held
+	GST_LONG_END                       // Released after GST_LONG
+} gst_type_t;
+
+typedef struct
+{
+	uint16_t long_ms;
+	uint16_t dbl_ms;                   // Double click window after a release, 0 = no double click
+	uint16_t repeat_ms;                // 0 = no auto-repeat
+} gst_config_t;
+
+typedef struct
+{
+	uint32_t ts_ms;                    // Debounce time base (deb_now())
+	uint8_t  button;                   // Index returned by gst_add()
+	uint8_t  type;                     // gst_type_t
+	uint16_t count;                    // GST_REPEAT: 1, 2, 3 ...
+} gst_event_t;
+
+// Pin of a debounce port (deb_add() index). cfg must stay valid (const / static).
+// Returns the button index, -1 if full or the pin is already used.
+int gst_add(uint32_t port, uint32_t pin, const gst_config_t *cfg);
+
+void gst_run(void);                    // Main loop: debounce events in, deadlines out
+uint8_t gst_read(gst_event_t *ev);     // 1 = event returned
+uint32_t gst_lost(void);               // Gesture events dropped, ring full
+
+#endif /* INC_GESTURE_H_ */
@@ -0,0 +1,151 @@
+/*
+ * Compile-time GPIO pin layer
+ *
+ * A pin is a port + number pair in one macro:   #define LED   GPIOA, 5
+ *   PIN_SET(LED) / PIN_CLR(LED) / PIN_WRITE(LED, v) / PIN_TOGGLE(LED)
+ *     one BSRR store each, no read-modify-write of ODR (an ISR driving another
+ *     pin of the same port can never be overwritten)
+ *   PIN_READ(LED), PIN_PORT(LED), PIN_MASK(LED)
+ *
+ * Pin setup is a static table per port, gpio_group_config() merges every entry
+ * into one mask/value pair per register and writes MODER, OTYPER, OSPEEDR,
+ * PUPDR (and AFR if needed) with one read-modify-write each. With a const table
+ * and optimisation on, the masks fold to constants.
+ */
+
+#ifndef INC_GPIO_PIN_H_
+#define INC_GPIO_PIN_H_
+
+#include "stm32f4xx.h"
+
+// MODER
+#define GP_IN         0U
+#define GP_OUT        1U
+#define GP_ALT        2U
+#define GP_ANALOG     3U
+// OTYPER
+#define GP_PP         0U
+#define GP_OD         1U
+// OSPEEDR
+#define GP_LOW        0U
+#define GP_MEDIUM     1U
+#define GP_FAST       2U
+#define GP_HIGH       3U
+// PUPDR
+#define GP_NOPULL     0U
+#define GP_UP         1U
+#define GP_DOWN       2U
+
+typedef struct
+{
+	uint8_t pin;
+	uint8_t mode;
+	uint8_t otype;
+	uint8_t speed;
+	uint8_t pull;
+	uint8_t af;
+} gpio_pin_cfg_t;
+
+// Table entries
+#define GP_INPUT(n, pull)             { (n), GP_IN, GP_PP, GP_LOW, (pull), 0U }
+#define GP_OUTPUT(n, otype, speed)    { (n), GP_OUT, (otype), (speed), GP_NOPULL, 0U }
+#define GP_AF(n, af, otype, speed)    { (n), GP_ALT, (otype), (speed), GP_NOPULL, (af) }
+#define GP_AIN(n)                     { (n), GP_ANALOG, GP_PP, GP_LOW, GP_NOPULL, 0U }
+
+/*==========================================================*/
+/*
+ * Pin access, the extra level of macros splits "GPIOA, 5" into two arguments
+ */
+
+#define PIN_PORT(...)      PIN_PORT_(__VA_ARGS__)
+#define PIN_MASK(...)      PIN_MASK_(__VA_ARGS__)
+#define PIN_SET(...)       PIN_SET_(__VA_ARGS__)
+#define PIN_CLR(...)       PIN_CLR_(__VA_ARGS__)
+#define PIN_WRITE(...)     PIN_WRITE_(__VA_ARGS__)
+#define PIN_TOGGLE(...)    PIN_TOGGLE_(__VA_ARGS__)
+#define PIN_READ(...)      PIN_READ_(__VA_ARGS__)
+
+#define PIN_PORT_(port, n)        (port)
+#define PIN_MASK_(port, n)        (1U << (n))
+#define PIN_SET_(port, n)         ((port)->BSRR = (1U << (n)))
+#define PIN_CLR_(port, n)         ((port)->BSRR = (1U << ((n) + 16U)))
+#define PIN_WRITE_(port, n, v)    ((port)->BSRR = ((v) ? (1U << (n)) : (1U << ((n) + 16U))))
+#define PIN_TOGGLE_(port, n)      gpio_toggle((port), (1U << (n)))
+#define PIN_READ_(port, n)        ((((port)->IDR) >> (n)) & 1U)
+
+// RCC->AHB1ENR bit of a port, OR several of them for one enable write
+#define GP_CLK(port)       (RCC_AHB1ENR_GPIOAEN << (((uint32_t)(port) - GPIOA_BASE) / 0x400U))
+
+/*==========================================================*/
+
+// Pins of 'mask' that are high go low and the others high, one BSRR store
+static inline void gpio_toggle(GPIO_TypeDef *port, uint32_t mask)
+{
+	uint32_t odr = port->ODR;
+
+	port->BSRR = ((odr & mask) << 16) | (~odr & mask);
+}
+
+// 16-bit pin mask -> 2 bits per pin (bit n -> bits 2n, 2n+1)
+static inline uint32_t gpio_mask2(uint32_t mask)
+{
+	uint32_t x = mask & 0xFFFFU;
+
+	x = (x | (x << 8)) & 0x00FF00FFU;
+	x = (x | (x << 4)) & 0x0F0F0F0FU;
+	x = (x | (x << 2)) & 0x33333333U;
+	x = (x | (x << 1)) & 0x55555555U;
+	return x * 3U;
+}
+
+static inline void gpio_group_config(GPIO_TypeDef *port, const gpio_pin_cfg_t *cfg, uint32_t n)
+{
+	uint32_t m1 = 0, m2 = 0, mode = 0, otype = 0, speed = 0, pull = 0;
+	uint32_t afm[2] = { 0, 0 }, af[2] = { 0, 0 };
+
+	for (uint32_t i = 0; i < n; i++)
+	{
+		uint32_t p = cfg[i].pin;
+
+		m1 |= (1U << p);
+		m2 |= (3U << (p * 2U));
+		mode |= ((uint32_t)cfg[i].mode << (p * 2U));
+		otype |= ((uint32_t)cfg[i].otype << p);
+		speed |= ((uint32_t)cfg[i].speed << (p * 2U));
+		pull |= ((uint32_t)cfg[i].pull << (p * 2U));
+		if (cfg[i].mode == GP_ALT)
+		{
+			afm[p >> 3] |= (0xFU << ((p & 7U) * 4U));
+			af[p >> 3] |= ((uint32_t)cfg[i].af << ((p & 7U) * 4U));
+		}
+	}
+
+	// AF selected before the pins switch to alternate mode
+	if (afm[0] != 0U)
+	{
+		port->AFR[0] = (port->AFR[0] & ~afm[0]) | af[0];
+	}
+	if (afm[1] != 0U)
+	{
+		port->AFR[1] = (port->AFR[1] & ~afm[1]) | af[1];
+	}
+	port->OTYPER = (port->OTYPER & ~m1) | otype;
+	port->OSPEEDR = (port->OSPEEDR & ~m2) | speed;
+	port->PUPDR = (port->PUPDR & ~m2) | pull;
+	port->MODER = (port->MODER & ~m2) | mode;
+}
+
+// Same setting for every pin of 'mask' (mask only known at run time)
+static inline void gpio_mask_config(GPIO_TypeDef *port, uint32_t mask, uint32_t mode,
+		uint32_t otype, uint32_t speed, uint32_t pull)
+{
+	uint32_t m2 = gpio_mask2(mask);
+	uint32_t ones = m2 & 0x55555555U;          // Low bit of every pair
+
+	port->OTYPER = (port->OTYPER & ~mask) | (otype ? mask : 0U);
+	port->OSPEEDR = (port->OSPEEDR & ~m2) | (ones * speed);
+	port->PUPDR = (port->PUPDR & ~m2) | (ones * pull);
+	port->MODER = (port->MODER & ~m2) | (ones * mode);
+}
+
+#endif /* INC_GPIO_PIN_H_ */
@@ -0,0 +1,163 @@
+/*
+ * Debounce service (see debounce.h)
+ */
+
+#include "debounce.h"
+#include "regclr.h"
+
+typedef struct
+{
+	GPIO_TypeDef *gpio;
+	uint16_t mask;
+	uint16_t active_low;
+	uint16_t state;                   // Debounced levels
+	uint16_t c0, c1;                  // Vertical counter, bit n = pin n
+} deb_port_t;
+
+static deb_port_t ports[DEB_MAX_PORTS];
+static volatile uint32_t nports;
+
+static deb_event_t ring[DEB_RING_LEN];
+static volatile uint32_t ring_wr;     // Written by the ISR only
+static volatile uint32_t ring_rd;     // Written by deb_read() only
+static volatile uint32_t lost;
+static volatile uint32_t now_ms;
+
+/*==========================================================*/
+
+static void push(uint8_t port, uint8_t pin, uint8_t pressed)
+{
+	uint32_t wr = ring_wr;
+
+	if ((wr - ring_rd) >= DEB_RING_LEN)
+	{
+		lost++;
+		return;
+	}
+	ring[wr & (DEB_RING_LEN - 1U)].ts_ms = now_ms;
+	ring[wr & (DEB_RING_LEN - 1U)].port = port;
+	ring[wr & (DEB_RING_LEN - 1U)].pin = pin;
+	ring[wr & (DEB_RING_LEN - 1U)].pressed = pressed;
+	__DMB();                                   // Entry complete before it is published
+	ring_wr = wr + 1U;
+}
+
+uint8_t deb_read(deb_event_t *ev)
+{
+	uint32_t rd = ring_rd;
+
+	if (rd == ring_wr)
+	{
+		return 0;
+	}
+	__DMB();
+	*ev = ring[rd & (DEB_RING_LEN - 1U)];
+	ring_rd = rd + 1U;
+	return 1;
+}
+
+uint16_t deb_state(uint32_t port)
+{
+	return (port < nports) ? ports[port].state : 0U;
+}
+
+uint32_t deb_lost(void)
+{
+	return lost;
+}
+
+uint32_t deb_now(void)
+{
+	return now_ms;
+}
+
+/*==========================================================*/
+
+int deb_add(GPIO_TypeDef *port, uint16_t mask, uint16_t active_low)
+{
+	uint32_t n = nports;
+
+	if (n >= DEB_MAX_PORTS)
+	{
+		return -1;
+	}
+
+	ports[n].gpio = port;
+	ports[n].mask = mask;
+	ports[n].active_low = active_low & mask;
+	ports[n].state = (uint16_t)(port->IDR & mask);   // Current levels, no event at start
+	ports[n].c0 = 0;
+	ports[n].c1 = 0;
+	__DMB();
+	nports = n + 1U;                                 // The ISR sees the port only now
+
+	return (int)n;
+}
+
+/*
+ * TIMER3: update interrupt every DEB_SAMPLE_MS
+ */
+void deb_init(void)
+{
+	uint32_t ppre1 = (RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos;
+	uint32_t timclk;
+
+	SystemCoreClockUpdate();
+	timclk = SystemCoreClock >> APBPrescTable[ppre1];
+	if (APBPrescTable[ppre1] != 0U)
+	{
+		timclk *= 2U;                              // APB1 timers run at 2 x PCLK1
+	}
+
+	RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+	(void)RCC->APB1ENR;
+
+	TIM3->CR1 &= ~TIM_CR1_CEN;
+	TIM3->PSC = (timclk / 10000U) - 1U;            // 100 us per count
+	TIM3->ARR = (DEB_SAMPLE_MS * 10U) - 1U;
+	TIM3->EGR = TIM_EGR_UG;
+	tim_sr_clear(TIM3, TIM_SR_UIF);
+	TIM3->DIER |= TIM_DIER_UIE;
+
+	NVIC_SetPriority(TIM3_IRQn, 3);
+	NVIC_EnableIRQ(TIM3_IRQn);
+
+	TIM3->CR1 |= TIM_CR1_CEN;
+}
+
+/*==========================================================*/
+/*
+ * Vertical counter, all pins of a port in parallel:
+ *   delta = pins whose sample differs from the debounced level
+ *   (c1:c0) counts 1, 2, 3, 0 while delta stays set, is reset where it clears
+ *   rolling over to 0 = 4 differing samples in a row -> accept the new level
+ */
+void TIM3_IRQHandler(void)
+{
+	tim_sr_clear(TIM3, TIM_SR_UIF);
+	now_ms += DEB_SAMPLE_MS;
+
+	for (uint32_t n = 0; n < nports; n++)
+	{
+		deb_port_t *p = &ports[n];
+		uint16_t raw = (uint16_t)(p->gpio->IDR & p->mask);
+		uint16_t delta = raw ^ p->state;
+		uint16_t changed;
+
+		p->c1 = (p->c1 ^ p->c0) & delta;
+		p->c0 = (uint16_t)~p->c0 & delta;
+		changed = delta & (uint16_t)~(p->c0 | p->c1);
+		p->state ^= changed;
+
+		// One event per accepted pin change, lowest pin first
+		while (changed != 0U)
+		{
+			uint32_t pin = (uint32_t)__builtin_ctz(changed);
+			uint16_t bit = (uint16_t)(1U << pin);
+			uint8_t level = (p->state & bit) ? 1U : 0U;
+
+			changed &= (uint16_t)~bit;
+			push((uint8_t)n, (uint8_t)pin, (p->active_low & bit) ? (uint8_t)!level : level);
+		}
+	}
+}
@@ -0,0 +1,266 @@
+/*
+ * Button gestures (see gesture.h)
+ * Runs in the main loop only, no locking.
+ */
+
+#include "gesture.h"
+
+#define NO_BUTTON    0xFFU
+
+// Button states
+enum
+{
+	S_IDLE = 0,
+	S_DOWN1,                           // First press, waiting for release / long_ms
+	S_UP1,                             // Released, waiting for a second press / dbl_ms
+	S_DOWN2,                           // Second press
+	S_LONG,                            // Long press, repeating
+	S_COUNT
+};
+
+// Inputs
+enum
+{
+	I_PRESS = 0,
+	I_RELEASE,
+	I_TIMEOUT,
+	I_COUNT
+};
+
+// Timer action of a transition
+enum
+{
+	T_KEEP = 0,                        // Deadline unchanged
+	T_OFF,
+	T_LONG,
+	T_DBL,
+	T_REPEAT
+};
+
+typedef struct
+{
+	uint8_t next;
+	uint8_t emit;                      // gst_type_t
+	uint8_t timer;
+} gst_step_t;
+
+static const gst_step_t table[S_COUNT][I_COUNT] =
+{
+	//               I_PRESS                        I_RELEASE                        I_TIMEOUT
+	[S_IDLE]  = { { S_DOWN1, GST_NONE, T_LONG }, { S_IDLE, GST_NONE, T_KEEP },     { S_IDLE, GST_NONE, T_OFF } },
+	[S_DOWN1] = { { S_DOWN1, GST_NONE, T_KEEP }, { S_UP1, GST_NONE, T_DBL },       { S_LONG, GST_LONG, T_REPEAT } },
+	[S_UP1]   = { { S_DOWN2, GST_NONE, T_OFF },  { S_UP1, GST_NONE, T_KEEP },      { S_IDLE, GST_CLICK, T_OFF } },
+	[S_DOWN2] = { { S_DOWN2, GST_NONE, T_KEEP }, { S_IDLE, GST_DOUBLE, T_OFF },    { S_DOWN2, GST_NONE, T_OFF } },
+	[S_LONG]  = { { S_LONG, GST_NONE, T_KEEP },  { S_IDLE, GST_LONG_END, T_OFF },  { S_LONG, GST_REPEAT, T_REPEAT } },
+};
+
+typedef struct
+{
+	const gst_config_t *cfg;
+	uint32_t deadline;
+	uint16_t repeats;
+	uint8_t state;
+	uint8_t armed;
+} gst_button_t;
+
+static gst_button_t buttons[GST_MAX_BUTTONS];
+static uint32_t nbuttons;
+static uint8_t map[DEB_MAX_PORTS][16];          // (port, pin) -> button, NO_BUTTON = not used
+static uint8_t map_ready;
+
+static uint32_t next_deadline;                  // Earliest armed deadline
+static uint32_t narmed;
+
+static gst_event_t ring[GST_RING_LEN];
+static uint32_t ring_wr, ring_rd;
+static uint32_t lost;
+
+/*==========================================================*/
+
+static void emit(uint32_t b, uint8_t type, uint32_t ts)
+{
+	if ((ring_wr - ring_rd) >= GST_RING_LEN)
+	{
+		lost++;
+		return;
+	}
+	ring[ring_wr & (GST_RING_LEN - 1U)].ts_ms = ts;
+	ring[ring_wr & (GST_RING_LEN - 1U)].button = (uint8_t)b;
+	ring[ring_wr & (GST_RING_LEN - 1U)].type = type;
+	ring[ring_wr & (GST_RING_LEN - 1U)].count = (type == GST_REPEAT) ? buttons[b].repeats : 0U;
+	ring_wr++;
+}
+
+uint8_t gst_read(gst_event_t *ev)
+{
+	if (ring_rd == ring_wr)
+	{
+		return 0;
+	}
+	*ev = ring[ring_rd & (GST_RING_LEN - 1U)];
+	ring_rd++;
+	return 1;
+}
+
+uint32_t gst_lost(void)
+{
+	return lost;
+}
+
+/*==========================================================*/
+
+static void arm(gst_button_t *p, uint32_t deadline)
+{
+	if (!p->armed)
+	{
+		narmed++;
+	}
+	p->armed = 1;
+	p->deadline = deadline;
+	if ((narmed == 1U) || ((int32_t)(deadline - next_deadline) < 0))
+	{
+		next_deadline = deadline;
+	}
+}
+
+static void disarm(gst_button_t *p)
+{
+	if (p->armed)
+	{
+		p->armed = 0;
+		narmed--;
+	}
+}
+
+// One transition at time 'ts'
+static void step(uint32_t b, uint32_t input, uint32_t ts)
+{
+	gst_button_t *p = &buttons[b];
+	const gst_step_t *s = &table[p->state][input];
+	const gst_config_t *c = p->cfg;
+
+	p->state = s->next;
+
+	if (s->emit == GST_LONG)
+	{
+		p->repeats = 0;
+	}
+	else if (s->emit == GST_REPEAT)
+	{
+		p->repeats++;
+	}
+
+	switch (s->timer)
+	{
+	case T_OFF:
+		disarm(p);
+		break;
+	case T_LONG:
+		arm(p, ts + c->long_ms);
+		break;
+	case T_DBL:
+		arm(p, ts + c->dbl_ms);                 // dbl_ms = 0: click at the next expire
+		break;
+	case T_REPEAT:
+		if (c->repeat_ms != 0U)
+		{
+			arm(p, ts + c->repeat_ms);
+		}
+		else
+		{
+			disarm(p);
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (s->emit != GST_NONE)
+	{
+		emit(b, s->emit, ts);
+	}
+}
+
+/*
+ * Fire every deadline up to 'now', oldest first per button (a repeat can
+ * become due more than once), then find the new earliest deadline
+ */
+static void expire(uint32_t now)
+{
+	if ((narmed == 0U) || ((int32_t)(now - next_deadline) < 0))
+	{
+		return;
+	}
+
+	for (uint32_t b = 0; b < nbuttons; b++)
+	{
+		gst_button_t *p = &buttons[b];
+
+		while (p->armed && ((int32_t)(now - p->deadline) >= 0))
+		{
+			step(b, I_TIMEOUT, p->deadline);
+		}
+	}
+
+	uint8_t first = 1;
+
+	for (uint32_t b = 0; b < nbuttons; b++)
+	{
+		if (buttons[b].armed && (first || ((int32_t)(buttons[b].deadline - next_deadline) < 0)))
+		{
+			next_deadline = buttons[b].deadline;
+			first = 0;
+		}
+	}
+}
+
+/*==========================================================*/
+
+int gst_add(uint32_t port, uint32_t pin, const gst_config_t *cfg)
+{
+	if (!map_ready)
+	{
+		for (uint32_t i = 0; i < DEB_MAX_PORTS; i++)
+		{
+			for (uint32_t j = 0; j < 16U; j++)
+			{
+				map[i][j] = NO_BUTTON;
+			}
+		}
+		map_ready = 1;
+	}
+
+	if ((nbuttons >= GST_MAX_BUTTONS) || (port >= DEB_MAX_PORTS) || (pin > 15U) ||
+	    (map[port][pin] != NO_BUTTON) || (cfg == 0))
+	{
+		return -1;
+	}
+
+	buttons[nbuttons].cfg = cfg;
+	buttons[nbuttons].state = S_IDLE;
+	buttons[nbuttons].armed = 0;
+	buttons[nbuttons].repeats = 0;
+	map[port][pin] = (uint8_t)nbuttons;
+
+	return (int)nbuttons++;
+}
+
+void gst_run(void)
+{
+	deb_event_t ev;
+
+	while (deb_read(&ev))
+	{
+		uint32_t b = (ev.port < DEB_MAX_PORTS) ? map[ev.port][ev.pin & 15U] : NO_BUTTON;
+
+		// Deadlines before this edge happened first
+		expire(ev.ts_ms);
+
+		if (b < nbuttons)
+		{
+			step(b, ev.pressed ? I_PRESS : I_RELEASE, ev.ts_ms);
+		}
+	}
+
+	expire(deb_now());
+}
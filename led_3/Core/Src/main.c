@@ -1,94 +1,64 @@
 /*
- * Toggle LED on each button press(edge detection manually)
+ * Toggle LED on each button click
+ * Click: toggle, double click: on, long press: off, held: flashes with every repeat
+ * Edges come from the TIM3 debounce service (debounce.h), gestures from gesture.h
  */
 #include "stm32f4xx.h"
+#include "debounce.h"
+#include "gesture.h"
+#include "gpio_pin.h"
 
-#define OFF 0
-#define ON  1
+#define LED      GPIOA, 5
+#define BUTTON   GPIOC, 13
 
 static void gpio_config(void);
-// void method_2(void);
+
+//long press 600 ms, double click window 250 ms, repeat every 150 ms
+static const gst_config_t button_cfg = { 600, 250, 150 };
 
 int main(void)
 {
 	gpio_config();
-	uint8_t current_state;
-	uint8_t previous_state=1;                           //active high because button not pressed its logic at 1
+
+	deb_init();                                         //TIM3 samples every 5 ms
+	int port = deb_add(PIN_PORT(BUTTON), PIN_MASK(BUTTON), PIN_MASK(BUTTON));   //PC13, active low (not pressed its logic at 1)
+	gst_add((uint32_t)port, 13, &button_cfg);
 	while(1)                                      //infinte loop
 	{
-		//another method not edge detection
-		//method_2();
-		current_state = (((GPIOC->IDR) >> (13)) & (1));
-		if((current_state == 0) && (previous_state == 1))
+		gst_event_t ev;
+
+		gst_run();                                      //debounced edges -> gestures
+		while(gst_read(&ev))
 		{
-			for(volatile uint32_t count=0;count<20000;count++);   //delay to overcome bouncing effect
-			current_state = (((GPIOC->IDR) >> (13)) & (1));
-			if(current_state == 0)
+			switch(ev.type)
 			{
-				if(GPIOA->ODR & (1U << 5))
-				{
-					GPIOA->BSRR = (1U <<(5+16));
-				}
-				else
-				{
-					GPIOA->BSRR = (1U << 5);
-				}
+			case GST_CLICK:
+			case GST_REPEAT:
+				PIN_TOGGLE(LED);                        //one BSRR store
+				break;
+			case GST_DOUBLE:
+				PIN_SET(LED);
+				break;
+			case GST_LONG:
+				PIN_CLR(LED);
+				break;
+			default:
+				break;
 			}
 		}
-		previous_state = current_state;
+		__WFI();                                        //sleep until the next sample
 	}
 
 }
 
 static void gpio_config(void)
 {
-	    // GPIOA is on AHB1 bus
-		RCC->AHB1ENR |=RCC_AHB1ENR_GPIOAEN ;      //Enableing the clock for GPIO
-
-		// GPIOC is on AHB1 bus
-		RCC->AHB1ENR |=RCC_AHB1ENR_GPIOCEN ;      //Enableing the clock for GPIOA
-		(void)RCC->AHB1ENR;                       // read-back to ensure clock is active
-		//-------------------------------------
-
-		GPIOA->MODER &= ~(3U << 10);             //Clearing the moder PA5 bits
-		GPIOA->MODER |= (1U << 10);              // setting the moder  PA5 bits as output configuration
-
-		GPIOA->OTYPER &= ~(1U << 5);               //Push -Pull type
-
-		GPIOA->OSPEEDR &= ~(3U << 10);           //Clearing the output speed PA5 bits
-
-		GPIOA->PUPDR &= ~(3U << 10);            //Clearing the PA5 PUPDR bits
-		//--------------------------------------
+	static const gpio_pin_cfg_t pa[] = { GP_OUTPUT(5, GP_PP, GP_LOW) };   //PA5 LED, push-pull
+	static const gpio_pin_cfg_t pc[] = { GP_INPUT(13, GP_UP) };           //PC13 button, pull-up
 
-		GPIOC->MODER &= ~(3U << 26);             //Clearing the moder PC13 bits to config as input mode
+	RCC->AHB1ENR |= GP_CLK(GPIOA) | GP_CLK(GPIOC);   //both ports, one write
+	(void)RCC->AHB1ENR;                              // read-back to ensure clock is active
 
-		GPIOC->OSPEEDR &= ~(3U << 26);           //Clearing the output speed PC13 bits to set  low speed
-
-		GPIOC->PUPDR &= ~(3U << 26);            //Clearing the PC13 PUPDR bits
-		GPIOC->PUPDR |= (1U << 26);             // config as pull-up
-
-}
-
-/*
- void method_2(void)
-{
-	if(!(GPIOC->IDR & (1U << 13)))
-			{
-				for(volatile uint32_t count=0;count<20000;count++);   //delay to overcome bouncing effecT
-				if(!(GPIOC->IDR & (1U << 13)))
-				{
-					if(current_state == OFF)
-					{
-						GPIOA->BSRR = (1U << 5);                           //LED on
-						current_state =ON;
-					}
-					else
-					{
-						GPIOA->BSRR = (1U <<(5+16));                       //LED off
-						current_state=OFF;
-					}
-				}
-			}
-			while(!(GPIOC->IDR & (1U << 13)));                    //wait untile switch relese
+	gpio_group_config(GPIOA, pa, 1);                 //one RMW per register and port
+	gpio_group_config(GPIOC, pc, 1);
 }
-*/